@@ -290,6 +290,9 @@ void QuitAudacity(bool bForce)
    //release ODManager Threads
    ODManager::Quit();
 
+   //release the spectrogram's threads
+   WaveClip::StopSpectrumWorkers();
+
    //print out profile if we have one by deleting it
    //temporarilly commented out till it is added to all projects
    //delete Profiler::Instance();
@@ -1901,7 +1904,6 @@ int AudacityApp::OnExit()
    UnloadEffects();
 
    DeinitFFT();
-   BlockFile::Deinit();
 
    DeinitAudioIO();
 
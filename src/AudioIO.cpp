@@ -321,6 +321,13 @@ writing audio.
    #define UPPER_BOUND 1.0
 #endif
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   // How far, at least, the realtime effects run ahead of the device.  A
+   // change to an effect's settings is heard after about this long.
+   #define REALTIME_LOOKAHEAD_SECS 0.1
+   #define REALTIME_SLEEP 5 /* milliseconds */
+#endif
+
 using std::max;
 using std::min;
 
@@ -451,6 +458,13 @@ class MidiThread : public AudioThread {
 };
 #endif
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+class RealtimeThread : public AudioThread {
+ public:
+   virtual ExitCode Entry();
+};
+#endif
+
 
 //////////////////////////////////////////////////////////////////////
 //
@@ -465,6 +479,9 @@ void InitAudioIO()
 #ifdef EXPERIMENTAL_MIDI_OUT
    gAudioIO->mMidiThread->Run();
 #endif
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   gAudioIO->mRealtimeThread->Run();
+#endif
 
    // Make sure device prefs are initialized
    if (gPrefs->Read(wxT("AudioIO/RecordingDevice"), wxT("")) == wxT("")) {
@@ -545,6 +562,16 @@ AudioIO::AudioIO()
    mSilentBuf = NULL;
    mLastSilentBufSize = 0;
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   mRealtimeStageActive = false;
+   mRealtimeBuffers = NULL;
+   mRealtimeScratch = NULL;
+   mRealtimeSkip = NULL;
+   mRealtimeOwed = NULL;
+   mRealtimeDelay = 0;
+   mRealtimeInputDone = false;
+#endif
+
    mStreamToken = 0;
 
    mLastPaError = paNoError;
@@ -604,6 +631,11 @@ AudioIO::AudioIO()
    mThread = new AudioThread();
    mThread->Create();
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   mRealtimeThread = new RealtimeThread();
+   mRealtimeThread->Create();
+#endif
+
 #if defined(USE_PORTMIXER)
    mPortMixer = NULL;
    mPreviousHWPlaythrough = -1.0;
@@ -638,6 +670,11 @@ AudioIO::~AudioIO()
    delete mMidiThread;
 #endif
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   mRealtimeThread->Delete();
+   delete mRealtimeThread;
+#endif
+
    /* Delete is a "graceful" way to stop the thread.
       (Kill is the not-graceful way.) */
    wxTheApp->Yield();
@@ -1337,6 +1374,18 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
                                                mRate, floatSample, false);
                mPlaybackMixers[i]->ApplyTrackGains(false);
             }
+
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+            if (mPlaybackTracks.GetCount() > 0)
+            {
+               // The look-ahead has to cover more than one device buffer
+               double latencyDuration = DEFAULT_LATENCY_DURATION;
+               gPrefs->Read(wxT("/AudioIO/LatencyDuration"), &latencyDuration);
+               double lookAheadSecs = wxMax(REALTIME_LOOKAHEAD_SECS,
+                                            2 * latencyDuration / 1000.0);
+               AllocateRealtimeBuffers((sampleCount)(mRate * lookAheadSecs + 0.5));
+            }
+#endif
          }
 
          if( mNumCaptureChannels > 0 )
@@ -1355,19 +1404,21 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
             }
 
             mCaptureBuffers = new RingBuffer* [mCaptureTracks.GetCount()];
-            mResample = new Resample* [mCaptureTracks.GetCount()];
             mFactor = sampleRate / mRate;
 
             // Set everything to zero in case we have to delete these due to a memory exception.
             memset(mCaptureBuffers, 0, sizeof(RingBuffer*)*mCaptureTracks.GetCount());
-            memset(mResample, 0, sizeof(Resample*)*mCaptureTracks.GetCount());
 
             for( unsigned int i = 0; i < mCaptureTracks.GetCount(); i++ )
             {
                mCaptureBuffers[i] = new RingBuffer( mCaptureTracks[i]->GetSampleFormat(),
                                                     captureBufferSize );
-               mResample[i] = new Resample(true, mFactor, mFactor); // constant rate resampling
             }
+
+            // One constant rate converter for all the channels, fed interleaved frames
+            if (mFactor != 1.0)
+               mResample = new Resample(true, mFactor, mFactor,
+                                        mCaptureTracks.GetCount(), captureBufferSize);
          }
       }
       catch(std::bad_alloc&)
@@ -1390,7 +1441,7 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
       em.RealtimeInitialize();
 
       // The following adds a new effect processor for each logical track and the
-      // group determination should mimic what is done in audacityAudioCallback()
+      // group determination should mimic what is done in ProcessRealtimeEffects()
       // when calling RealtimeProcess().
       int group = 0;
       for (size_t i = 0, cnt = mPlaybackTracks.GetCount(); i < cnt; i++)
@@ -1436,6 +1487,17 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
    while( mAudioThreadShouldCallFillBuffersOnce == true )
       wxMilliSleep( 50 );
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   if (mRealtimeBuffers)
+   {
+      // Start the look-ahead stage, and fill it before the device asks
+      // for anything
+      wxMutexLocker locker(mRealtimeStageMutex);
+      mRealtimeStageActive = true;
+      ProcessRealtimeEffects();
+   }
+#endif
+
 #ifdef EXPERIMENTAL_MIDI_OUT
    // if no playback, reset the midi time to zero to roughly sync
    // with recording (or if recording is not going to happen, just
@@ -1501,6 +1563,8 @@ int AudioIO::StartStream(WaveTrackArray playbackTracks,
 void AudioIO::StartStreamCleanup(bool bOnlyBuffers)
 {
 #if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   DeleteRealtimeBuffers();
+
    if (mNumPlaybackChannels > 0)
    {
       EffectManager::Get().RealtimeFinalize();
@@ -1533,9 +1597,7 @@ void AudioIO::StartStreamCleanup(bool bOnlyBuffers)
 
    if(mResample)
    {
-      for( unsigned int i = 0; i < mCaptureTracks.GetCount(); i++ )
-         delete mResample[i];
-      delete [] mResample;
+      delete mResample;
       mResample = NULL;
    }
 
@@ -1710,6 +1772,12 @@ void AudioIO::StopStream()
    wxMutexLocker locker(mSuspendAudioThread);
 
 #if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   // Stop the look-ahead stage before the effects go away.  The callback
+   // plays out what it already holds.
+   mRealtimeStageMutex.Lock();
+   mRealtimeStageActive = false;
+   mRealtimeStageMutex.Unlock();
+
    // No longer need effects processing
    if (mNumPlaybackChannels > 0)
    {
@@ -1864,6 +1932,10 @@ void AudioIO::StopStream()
          delete[] mPlaybackMixers;
       }
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+      DeleteRealtimeBuffers();
+#endif
+
       //
       // Offset all recorded tracks to account for latency
       //
@@ -1885,7 +1957,6 @@ void AudioIO::StopStream()
          for( unsigned int i = 0; i < mCaptureTracks.GetCount(); i++ )
             {
                delete mCaptureBuffers[i];
-               delete mResample[i];
 
                WaveTrack* track = mCaptureTracks[i];
                track->Flush();
@@ -1933,7 +2004,8 @@ void AudioIO::StopStream()
             }
 
          delete[] mCaptureBuffers;
-         delete[] mResample;
+         delete mResample;
+         mResample = NULL;
       }
    }
 
@@ -2360,6 +2432,22 @@ AudioThread::ExitCode AudioThread::Entry()
    return 0;
 }
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+RealtimeThread::ExitCode RealtimeThread::Entry()
+{
+   while( !TestDestroy() )
+   {
+      gAudioIO->mRealtimeStageMutex.Lock();
+      gAudioIO->ProcessRealtimeEffects();
+      gAudioIO->mRealtimeStageMutex.Unlock();
+
+      Sleep(REALTIME_SLEEP);
+   }
+
+   return 0;
+}
+#endif
+
 
 #ifdef EXPERIMENTAL_MIDI_OUT
 MidiThread::ExitCode MidiThread::Entry()
@@ -2915,6 +3003,16 @@ void AudioIO::FillBuffers()
             }
 
          } while (mPlayLooped && secsAvail > 0 && deltat > 0);
+
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+         // The whole selection is buffered, so once the look-ahead stage
+         // has taken it all, it may flush the effects
+         if (!mPlayLooped && mWarpedTime >= mWarpedLength)
+         {
+            wxMutexLocker locker(mRealtimeStageMutex);
+            mRealtimeInputDone = true;
+         }
+#endif
       }
    }  // end of playback buffering
 
@@ -2935,6 +3033,37 @@ void AudioIO::FillBuffers()
          XMLStringWriter blockFileLog;
          int numChannels = mCaptureTracks.GetCount();
 
+         // When re-sampling, all channels go through the converter together
+         // as interleaved frames, and each track then appends its own
+         // column of the result.
+         float *resampled = NULL;
+         int size = 0;
+         if( mFactor != 1.0 )
+         {
+            int avail = commonlyAvail;
+            int used = 0;
+            size = lrint(avail * mFactor);
+            float *temp = (float *)NewSamples(avail, floatSample);
+            float *interleaved = (float *)NewSamples(avail * numChannels, floatSample);
+            resampled = (float *)NewSamples(size * numChannels, floatSample);
+
+            for( i = 0; (int)i < numChannels; i++ )
+            {
+               mCaptureBuffers[i]->Get((samplePtr)temp, floatSample, avail);
+               for( int j = 0; j < avail; j++ )
+                  interleaved[j * numChannels + i] = temp[j];
+            }
+
+            /* we are re-sampling on the fly. The last resampling call
+             * must flush any samples left in the rate conversion buffer
+             * so that they get recorded
+             */
+            size = mResample->Process(mFactor, interleaved, avail, !IsStreamActive(),
+                                      &used, resampled, size);
+            DeleteSamples((samplePtr)temp);
+            DeleteSamples((samplePtr)interleaved);
+         }
+
          for( i = 0; (int)i < numChannels; i++ )
          {
             int avail = commonlyAvail;
@@ -2952,20 +3081,8 @@ void AudioIO::FillBuffers()
             }
             else
             {
-               int size = lrint(avail * mFactor);
-               samplePtr temp1 = NewSamples(avail, floatSample);
-               samplePtr temp2 = NewSamples(size, floatSample);
-               mCaptureBuffers[i]->Get(temp1, floatSample, avail);
-               /* we are re-sampling on the fly. The last resampling call
-                * must flush any samples left in the rate conversion buffer
-                * so that they get recorded
-                */
-               size = mResample[i]->Process(mFactor, (float *)temp1, avail, !IsStreamActive(),
-                                            &size, (float *)temp2, size);
-               mCaptureTracks[i]-> Append(temp2, floatSample, size, 1,
-                                          &appendLog);
-               DeleteSamples(temp1);
-               DeleteSamples(temp2);
+               mCaptureTracks[i]-> Append((samplePtr)(resampled + i), floatSample,
+                                          size, numChannels, &appendLog);
             }
 
             if (!appendLog.IsEmpty())
@@ -2978,12 +3095,205 @@ void AudioIO::FillBuffers()
             }
          }
 
+         if (resampled)
+            DeleteSamples((samplePtr)resampled);
+
          if (mListener && !blockFileLog.IsEmpty())
             mListener->OnAudioIONewBlockFiles(blockFileLog);
       }
    }  // end of record buffering
 }
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+// Allocates the look-ahead stage for StartStream().  Like the other
+// allocations there, this throws std::bad_alloc when memory runs out.
+void AudioIO::AllocateRealtimeBuffers(sampleCount lookAhead)
+{
+   unsigned int numTracks = mPlaybackTracks.GetCount();
+
+   mRealtimeBuffers = new RingBuffer* [numTracks];
+   mRealtimeScratch = new float* [numTracks];
+
+   // Set everything to zero in case we have to delete these due to a memory exception.
+   memset(mRealtimeBuffers, 0, sizeof(RingBuffer*)*numTracks);
+   memset(mRealtimeScratch, 0, sizeof(float*)*numTracks);
+
+   mRealtimeSkip = new sampleCount[numTracks];
+   mRealtimeOwed = new sampleCount[numTracks];
+
+   for (unsigned int t = 0; t < numTracks; t++)
+   {
+      mRealtimeBuffers[t] = new RingBuffer(floatSample, lookAhead);
+      mRealtimeScratch[t] = new float[REALTIME_MAX_BLOCK_SIZE];
+      mRealtimeSkip[t] = 0;
+      mRealtimeOwed[t] = 0;
+   }
+
+   mRealtimeDelay = 0;
+   mRealtimeInputDone = false;
+}
+
+void AudioIO::DeleteRealtimeBuffers()
+{
+   wxMutexLocker locker(mRealtimeStageMutex);
+   mRealtimeStageActive = false;
+
+   unsigned int numTracks = mPlaybackTracks.GetCount();
+
+   if (mRealtimeBuffers)
+   {
+      for (unsigned int t = 0; t < numTracks; t++)
+         delete mRealtimeBuffers[t];
+      delete [] mRealtimeBuffers;
+      mRealtimeBuffers = NULL;
+   }
+
+   if (mRealtimeScratch)
+   {
+      for (unsigned int t = 0; t < numTracks; t++)
+         delete [] mRealtimeScratch[t];
+      delete [] mRealtimeScratch;
+      mRealtimeScratch = NULL;
+   }
+
+   delete [] mRealtimeSkip;
+   mRealtimeSkip = NULL;
+   delete [] mRealtimeOwed;
+   mRealtimeOwed = NULL;
+}
+
+// Runs the realtime effects over the next stretch of mixed playback audio
+// and passes it on to the PortAudio callback through mRealtimeBuffers.
+// This keeps the plugins' DSP, and the lock EffectManager takes around
+// it, out of the callback, which only mixes finished samples.  Each ring
+// buffer has a single writer and a single reader, so the handoff needs no
+// lock.  mRealtimeBuffers are short, so the effects never run more than a
+// fraction of a second ahead of what is heard.
+//
+// Effects that delay their output report it through GetRealtimeDelay().
+// That much is dropped from the start of the processed tracks and made
+// up at the end by feeding the effects silence, so they stay in line
+// with the unprocessed ones.
+//
+// Call with mRealtimeStageMutex held.  The group numbering must match the
+// processors added in StartStream().
+void AudioIO::ProcessRealtimeEffects()
+{
+   if (!mRealtimeStageActive || mPaused)
+      return;
+
+   EffectManager & em = EffectManager::Get();
+   unsigned int numTracks = mPlaybackTracks.GetCount();
+   bool *processed = (bool *) alloca(numTracks * sizeof(bool));
+   unsigned int t;
+
+   while (numTracks > 0)
+   {
+      // Take the same amount from every track, so that the channels of a
+      // group stay in step, and no more than every track has room for
+      int len = REALTIME_MAX_BLOCK_SIZE;
+      int room = REALTIME_MAX_BLOCK_SIZE;
+      sampleCount owed = 0;
+      for (t = 0; t < numTracks; t++)
+      {
+         len = wxMin(len, mPlaybackBuffers[t]->AvailForGet());
+         room = wxMin(room, mRealtimeBuffers[t]->AvailForPut());
+         owed = wxMax(owed, mRealtimeOwed[t]);
+      }
+
+      // Once the whole selection has gone through, feed the effects
+      // silence until they've given back the output that was dropped
+      bool flushing = (len == 0 && mRealtimeInputDone && owed > 0);
+      if (flushing)
+         len = (int) wxMin((sampleCount) room, owed);
+      else
+         len = wxMin(len, room);
+
+      if (len <= 0)
+         break;
+
+      for (t = 0; t < numTracks; t++)
+      {
+         if (flushing)
+            ClearSamples((samplePtr) mRealtimeScratch[t], floatSample, 0, len);
+         else
+            mPlaybackBuffers[t]->Get((samplePtr) mRealtimeScratch[t],
+                                     floatSample, len);
+      }
+
+      em.RealtimeProcessStart();
+
+      // Muted tracks are processed too, so that unmuting one doesn't
+      // bring back stale effect state or a different delay
+      float *bufs[2];
+      int group = 0;
+      for (t = 0; t < numTracks; t++)
+      {
+         WaveTrack *vt = mPlaybackTracks[t];
+         bool selected = vt->GetSelected();
+
+         int chanCnt = 1;
+         bufs[0] = mRealtimeScratch[t];
+         processed[t] = selected;
+         if (vt->GetLinked() && t + 1 < numTracks)
+         {
+            t++;
+            bufs[1] = mRealtimeScratch[t];
+            processed[t] = selected;
+            chanCnt++;
+         }
+
+         if (selected)
+            em.RealtimeProcess(group, chanCnt, bufs, len);
+
+         group++;
+      }
+
+      em.RealtimeProcessEnd();
+
+      sampleCount delay = em.GetRealtimeDelay();
+      mRealtimeDelay += delay;
+
+      for (t = 0; t < numTracks; t++)
+      {
+         if (processed[t])
+            mRealtimeSkip[t] += delay;
+
+         int skip = (int) wxMin(mRealtimeSkip[t], (sampleCount) len);
+         mRealtimeSkip[t] -= skip;
+         mRealtimeOwed[t] += skip;
+
+         int put = len - skip;
+         if (flushing)
+         {
+            put = (int) wxMin((sampleCount) put, mRealtimeOwed[t]);
+            mRealtimeOwed[t] -= put;
+         }
+
+         mRealtimeBuffers[t]->Put((samplePtr) (mRealtimeScratch[t] + skip),
+                                  floatSample, put);
+      }
+   }
+}
+
+// Empties the look-ahead stage after a seek has flushed the playback ring
+// buffers.  Whatever the effects still hold from before the seek is
+// dropped from their output, as at the start of the stream.
+//
+// Call with mRealtimeStageMutex held.
+void AudioIO::ResetRealtimeEffects()
+{
+   for (unsigned int t = 0; t < mPlaybackTracks.GetCount(); t++)
+   {
+      mRealtimeBuffers[t]->Discard(mRealtimeBuffers[t]->AvailForGet());
+      mRealtimeSkip[t] = mPlaybackTracks[t]->GetSelected() ? mRealtimeDelay : 0;
+      mRealtimeOwed[t] = 0;
+   }
+
+   mRealtimeInputDone = false;
+}
+#endif
+
 void AudioIO::SetListener(AudioIOListener* listener)
 {
    if (IsBusy())
@@ -3595,11 +3905,21 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
                gAudioIO->mWarpedTime = gAudioIO->mTimeTrack->ComputeWarpedLength(gAudioIO->mT0, gAudioIO->mTime);
             else
                gAudioIO->mWarpedTime = gAudioIO->mTime - gAudioIO->mT0;
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+            // The look-ahead stage reads the playback ring buffers, so it
+            // has to wait while they're flushed
+            gAudioIO->mRealtimeStageMutex.Lock();
+#endif
             for (i = 0; i < (unsigned int)numPlaybackTracks; i++)
             {
                gAudioIO->mPlaybackMixers[i]->Reposition(gAudioIO->mTime);
                gAudioIO->mPlaybackBuffers[i]->Discard(gAudioIO->mPlaybackBuffers[i]->AvailForGet());
             }
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+            if (gAudioIO->mRealtimeBuffers)
+               gAudioIO->ResetRealtimeEffects();
+            gAudioIO->mRealtimeStageMutex.Unlock();
+#endif
 
             // Reload the ring buffers
             gAudioIO->mAudioThreadShouldCallFillBuffersOnce = true;
@@ -3633,12 +3953,12 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
          }
 
 #if defined(EXPERIMENTAL_REALTIME_EFFECTS)
-         EffectManager & em = EffectManager::Get();
-         em.RealtimeProcessStart();
+         // The look-ahead stage has already run the realtime effects
+         RingBuffer **playbackBuffers = gAudioIO->mRealtimeBuffers;
+#else
+         RingBuffer **playbackBuffers = gAudioIO->mPlaybackBuffers;
 #endif
 
-         bool selected = false;
-         int group = 0;
          int chanCnt = 0;
          float rate = 0.0;
          for (t = 0; t < numPlaybackTracks; t++)
@@ -3662,7 +3982,6 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
 
                rate = vt->GetRate();
                linkFlag = vt->GetLinked();
-               selected = vt->GetSelected();
 
                // If we have a mono track, clear the right channel
                if (!linkFlag)
@@ -3677,15 +3996,15 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
             // this is original code prior to r10680 -RBD
             if (cut)
             {
-               gAudioIO->mPlaybackBuffers[t]->Discard(framesPerBuffer);
+               playbackBuffers[t]->Discard(framesPerBuffer);
                // keep going here.  
                // we may still need to issue a paComplete.
             }
             else
             {
-               len = gAudioIO->mPlaybackBuffers[t]->Get((samplePtr)tempBufs[chanCnt],
-                                                         floatSample,
-                                                         (int)framesPerBuffer);
+               len = playbackBuffers[t]->Get((samplePtr)tempBufs[chanCnt],
+                                             floatSample,
+                                             (int)framesPerBuffer);
                chanCnt++;
             }
 
@@ -3708,23 +4027,16 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
             if (cut)
             {
                len = (unsigned int)
-                  gAudioIO->mPlaybackBuffers[t]->Discard(framesPerBuffer);
+                  playbackBuffers[t]->Discard(framesPerBuffer);
             } else
             {
                len = (unsigned int)
-                  gAudioIO->mPlaybackBuffers[t]->Get((samplePtr)tempFloats,
-                                                     floatSample,
-                                                     (int)framesPerBuffer);
+                  playbackBuffers[t]->Get((samplePtr)tempFloats,
+                                          floatSample,
+                                          (int)framesPerBuffer);
             }
 #endif
 
-#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
-            if( !cut && selected )
-            {
-               len = em.RealtimeProcess(group, chanCnt, tempBufs, len);
-            }
-            group++;
-#endif
             // If our buffer is empty and the time indicator is past
             // the end, then we've actually finished playing the entire
             // selection.
@@ -3783,10 +4095,6 @@ int audacityAudioCallback(const void *inputBuffer, void *outputBuffer,
             chanCnt = 0;
          }
 
-#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
-         em.RealtimeProcessEnd();
-#endif
-
          gAudioIO->mLastPlaybackTimeMillis = ::wxGetLocalTimeMillis();
 
          //
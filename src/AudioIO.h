@@ -360,6 +360,13 @@ private:
                              sampleFormat captureFormat);
    void FillBuffers();
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   void AllocateRealtimeBuffers(sampleCount lookAhead);
+   void DeleteRealtimeBuffers();
+   void ProcessRealtimeEffects();
+   void ResetRealtimeEffects();
+#endif
+
 #ifdef EXPERIMENTAL_MIDI_OUT
    void PrepareMidiIterator(bool send = true, double offset = 0);
    bool StartPortMidiStream();
@@ -487,7 +494,10 @@ private:
 #ifdef EXPERIMENTAL_MIDI_OUT
    AudioThread         *mMidiThread;
 #endif
-   Resample          **mResample;
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   AudioThread         *mRealtimeThread;
+#endif
+   Resample          *mResample;
    RingBuffer        **mCaptureBuffers;
    WaveTrackArray      mCaptureTracks;
    RingBuffer        **mPlaybackBuffers;
@@ -560,12 +570,35 @@ private:
    samplePtr mSilentBuf;
    sampleCount mLastSilentBufSize;
 
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   // The look-ahead stage.  mRealtimeThread takes mixed audio from
+   // mPlaybackBuffers, runs it through the realtime effects and leaves it
+   // in mRealtimeBuffers, which hold only a fraction of a second and are
+   // what the PortAudio callback reads.  Everything below is guarded by
+   // mRealtimeStageMutex, which the stage holds while it runs.
+   wxMutex             mRealtimeStageMutex;
+   bool                mRealtimeStageActive;
+   RingBuffer        **mRealtimeBuffers;
+   float             **mRealtimeScratch;
+   // Output still to be dropped, and output dropped but not yet made up
+   // at the end, per track, to cancel the delay the effects report
+   sampleCount        *mRealtimeSkip;
+   sampleCount        *mRealtimeOwed;
+   // Total delay reported by the effects during this stream
+   sampleCount         mRealtimeDelay;
+   // Set by FillBuffers() once the last of the selection is buffered
+   bool                mRealtimeInputDone;
+#endif
+
    AudioIOListener*    mListener;
 
    friend class AudioThread;
 #ifdef EXPERIMENTAL_MIDI_OUT
    friend class MidiThread;
 #endif
+#if defined(EXPERIMENTAL_REALTIME_EFFECTS)
+   friend class RealtimeThread;
+#endif
 
    friend void InitAudioIO();
    friend void DeinitAudioIO();
@@ -51,6 +51,7 @@ out.
 #include <wx/log.h>
 #include <wx/math.h>
 
+#include "AudacityApp.h"
 #include "BlockFile.h"
 #include "Internat.h"
 
@@ -84,7 +85,104 @@ SummaryInfo::SummaryInfo(sampleCount samples)
    totalSummaryBytes = offset256 + (frames256 * bytesPerFrame);
 }
 
-char *BlockFile::fullSummary = 0;
+SampleStats::SampleStats()
+{
+   Clear();
+}
+
+void SampleStats::Clear()
+{
+   count = 0;
+   sum = 0.0;
+   sumsq = 0.0;
+   min = FLT_MAX;
+   max = -FLT_MAX;
+   clipped = 0;
+}
+
+void SampleStats::Add(const SampleStats &other)
+{
+   count += other.count;
+   sum += other.sum;
+   sumsq += other.sumsq;
+   if (other.min < min)
+      min = other.min;
+   if (other.max > max)
+      max = other.max;
+   clipped += other.clipped;
+}
+
+void SampleStats::Accumulate(const float *buffer, sampleCount len)
+{
+   // Four independent accumulators, so that the compiler can keep them
+   // in one vector register each
+   double sums[4] = { 0.0, 0.0, 0.0, 0.0 };
+   double sumsqs[4] = { 0.0, 0.0, 0.0, 0.0 };
+   float mins[4] = { min, min, min, min };
+   float maxs[4] = { max, max, max, max };
+   int k;
+
+   sampleCount i = 0;
+   for (; i + 4 <= len; i += 4) {
+      for (k = 0; k < 4; k++) {
+         float sample = buffer[i + k];
+         sums[k] += sample;
+         sumsqs[k] += sample * sample;
+         mins[k] = sample < mins[k] ? sample : mins[k];
+         maxs[k] = sample > maxs[k] ? sample : maxs[k];
+      }
+   }
+   for (; i < len; i++) {
+      float sample = buffer[i];
+      sums[0] += sample;
+      sumsqs[0] += sample * sample;
+      mins[0] = sample < mins[0] ? sample : mins[0];
+      maxs[0] = sample > maxs[0] ? sample : maxs[0];
+   }
+
+   for (k = 0; k < 4; k++) {
+      sum += sums[k];
+      sumsq += sumsqs[k];
+      if (mins[k] < min)
+         min = mins[k];
+      if (maxs[k] > max)
+         max = maxs[k];
+   }
+
+   // Clipping is rare; only look for it if the block reaches full scale
+   if (min <= -MAX_AUDIO || max >= MAX_AUDIO) {
+      for (i = 0; i < len; i++) {
+         if (fabs(buffer[i]) >= MAX_AUDIO)
+            clipped++;
+      }
+   }
+   count += len;
+}
+
+static ODLock sSilencerMutex;
+
+BlockFileSilencer::BlockFileSilencer(bool silent)
+{
+   mLogNull = NULL;
+   if (silent) {
+      sSilencerMutex.Lock();
+      mLogNull = new wxLogNull();
+   }
+}
+
+void BlockFileSilencer::Release()
+{
+   if (mLogNull) {
+      delete mLogNull;
+      mLogNull = NULL;
+      sSilencerMutex.Unlock();
+   }
+}
+
+// Serial numbers for BlockFile::GetSerial().  Blocks are made on the
+// recording and on-demand threads as well as the main one.
+static sampleCount sNextSerial = 0;
+static ODLock sNextSerialMutex;
 
 /// Initializes the base BlockFile data.  The block is initially
 /// unlocked and its reference count is 1.
@@ -103,7 +201,12 @@ BlockFile::BlockFile(wxFileName fileName, sampleCount samples):
    mLen(samples),
    mSummaryInfo(samples)
 {
+   mStatsValid = false;
    mSilentLog=FALSE;
+
+   sNextSerialMutex.Lock();
+   mSerial = sNextSerial++;
+   sNextSerialMutex.Unlock();
 }
 
 BlockFile::~BlockFile()
@@ -179,21 +282,17 @@ bool BlockFile::Deref()
       return false;
 }
 
-void BlockFile::Deinit()
-{
-   if(fullSummary)delete[] fullSummary;
-}
-
 /// Get a buffer containing a summary block describing this sample
 /// data.  This must be called by derived classes when they
 /// are constructed, to allow them to construct their summary data,
 /// after which they should write that data to their disk file.
 ///
 /// This method also has the side effect of setting the mMin, mMax,
-/// and mRMS members of this class.
+/// mRMS and mStats members of this class.
 ///
-/// You must not delete the returned buffer; it is static to this
-/// method.
+/// The returned buffer belongs to the caller, who must delete[] it
+/// as a char array.  Nothing is shared between calls, so blocks may
+/// be summarized on several threads at once.
 ///
 /// @param buffer A buffer containing the sample data to be analyzed
 /// @param len    The length of the sample data
@@ -201,18 +300,84 @@ void BlockFile::Deinit()
 void *BlockFile::CalcSummary(samplePtr buffer, sampleCount len,
                              sampleFormat format)
 {
-   if(fullSummary)delete[] fullSummary;
-   fullSummary = new char[mSummaryInfo.totalSummaryBytes];
+   char *fullSummary = new char[mSummaryInfo.totalSummaryBytes];
 
    memcpy(fullSummary, headerTag, headerTagLen);
 
-   float *summary64K = (float *)(fullSummary + mSummaryInfo.offset64K);
-   float *summary256 = (float *)(fullSummary + mSummaryInfo.offset256);
+   float *fbuffer;
+   if (format == floatSample)
+      fbuffer = (float *)buffer;
+   else {
+      fbuffer = new float[len];
+      CopySamples(buffer, format,
+                  (samplePtr)fbuffer, floatSample, len);
+   }
+
+   CalcSummaryFromBuffer(fbuffer, len,
+      (float *)(fullSummary + mSummaryInfo.offset256),
+      (float *)(fullSummary + mSummaryInfo.offset64K));
+
+   SampleStats stats;
+   stats.Accumulate(fbuffer, len);
+   mStatsMutex.Lock();
+   mStats = stats;
+   mStatsValid = true;
+   mStatsMutex.Unlock();
+
+   if (format != floatSample)
+      delete[] fbuffer;
 
-   float *fbuffer = new float[len];
-   CopySamples(buffer, format,
-               (samplePtr)fbuffer, floatSample, len);
+   return fullSummary;
+}
 
+/// Min, max and sum of squares of up to 256 samples.  The min and max are
+/// taken four samples at a time into independent accumulators, which lets
+/// the compiler use vector instructions, and in any order give the same
+/// result.  The sum of squares is still added up one sample after another,
+/// as before: summed in another order it would round differently, and the
+/// RMS in the summaries written would change in the last bits.
+static inline void MinMaxSumsq(const float *buffer, int len,
+                               float *outMin, float *outMax, float *outSumsq)
+{
+   float mins[4], maxs[4];
+   float sumsq = 0.0f;
+   int j, k;
+
+   for (k = 0; k < 4; k++)
+      mins[k] = maxs[k] = buffer[0];
+
+   for (j = 0; j + 4 <= len; j += 4) {
+      for (k = 0; k < 4; k++) {
+         float f1 = buffer[j + k];
+         mins[k] = f1 < mins[k] ? f1 : mins[k];
+         maxs[k] = f1 > maxs[k] ? f1 : maxs[k];
+      }
+   }
+   for (; j < len; j++) {
+      float f1 = buffer[j];
+      mins[0] = f1 < mins[0] ? f1 : mins[0];
+      maxs[0] = f1 > maxs[0] ? f1 : maxs[0];
+   }
+
+   for (j = 0; j < len; j++)
+      sumsq += buffer[j] * buffer[j];
+
+   *outMin = wxMin(wxMin(mins[0], mins[1]), wxMin(mins[2], mins[3]));
+   *outMax = wxMax(wxMax(maxs[0], maxs[1]), wxMax(maxs[2], maxs[3]));
+   *outSumsq = sumsq;
+}
+
+/// Fills in the 256- and 64K-sample summaries of some float sample data,
+/// and sets mMin, mMax and mRMS from them.  Shared by all the
+/// CalcSummary() implementations.
+///
+/// @param fbuffer    The sample data
+/// @param len        The length of the sample data
+/// @param summary256 Where to put mSummaryInfo.frames256 256-sample frames
+/// @param summary64K Where to put mSummaryInfo.frames64K 64K-sample frames
+void BlockFile::CalcSummaryFromBuffer(const float *fbuffer, sampleCount len,
+                                      float *summary256, float *summary64K)
+{
    sampleCount sumLen;
    sampleCount i, j, jcount;
 
@@ -223,20 +388,10 @@ void *BlockFile::CalcSummary(samplePtr buffer, sampleCount len,
    sumLen = (len + 255) / 256;
 
    for (i = 0; i < sumLen; i++) {
-      min = fbuffer[i * 256];
-      max = fbuffer[i * 256];
-      sumsq = ((float)min) * ((float)min);
       jcount = 256;
       if (i * 256 + jcount > len)
          jcount = len - i * 256;
-      for (j = 1; j < jcount; j++) {
-         float f1 = fbuffer[i * 256 + j];
-         sumsq += ((float)f1) * ((float)f1);
-         if (f1 < min)
-            min = f1;
-         else if (f1 > max)
-            max = f1;
-      }
+      MinMaxSumsq(&fbuffer[i * 256], (int)jcount, &min, &max, &sumsq);
 
       float rms = (float)sqrt(sumsq / jcount);
 
@@ -298,10 +453,6 @@ void *BlockFile::CalcSummary(samplePtr buffer, sampleCount len,
    mMin = min;
    mMax = max;
    mRMS = sqrt(sumsq / sumLen);
-
-   delete[] fbuffer;
-
-   return fullSummary;
 }
 
 static void ComputeMinMax256(float *summary256,
@@ -370,9 +521,90 @@ void BlockFile::FixSummary(void *data)
    }
 }
 
+/// Reads part of the summary section.  This default implementation
+/// reads the whole summary and copies out the part asked for.
+///
+/// @param *data  Where to put the bytes; it must be at least bytes long
+/// @param offset Offset of the first byte within the summary section
+/// @param bytes  Number of bytes to read
+bool BlockFile::ReadSummaryPart(void *data, int offset, int bytes)
+{
+   char *summary = new char[mSummaryInfo.totalSummaryBytes];
+   bool result = this->ReadSummary(summary);
+   memcpy(data, summary + offset, bytes);
+   delete[] summary;
+   return result;
+}
+
+/// FixSummary() needs the whole summary to decide whether it was saved
+/// with the other byte order.  For a run of 256-sample frames read on
+/// their own, check instead that every frame is plausible for this
+/// block, and swap if that makes them so.
+void BlockFile::FixSummaryPart(void *data, int frames)
+{
+   if (mSummaryInfo.format != floatSample ||
+       mSummaryInfo.fields != 3)
+      return;
+
+   // The block's extremes may have been through a decimal round trip
+   // in the project file, so allow a little slack.
+   float lo = mMin - 0.0001f;
+   float hi = mMax + 0.0001f;
+   float *summary = (float *)data;
+   int i;
+
+   for (int attempt = 0; attempt < 2; attempt++) {
+      for (i = 0; i < frames; i++) {
+         float min = summary[3 * i];
+         float max = summary[3 * i + 1];
+         float rms = summary[3 * i + 2];
+         if (!(min >= lo && min <= max && max <= hi &&
+               rms >= 0 && rms <= wxMax(-min, max) + 0.0001f))
+            break;
+      }
+      if (i == frames)
+         return;
+
+      for (i = 0; i < 3 * frames; i++) {
+         unsigned int *word = (unsigned int *)&summary[i];
+         *word = wxUINT32_SWAP_ALWAYS(*word);
+      }
+   }
+   // Neither order looked right; the second swap has put it back.
+}
+
+/// Reads the given sample range of a block and folds it into running
+/// min, max and sum-of-squares accumulators.
+static void AccumulateMinMax(BlockFile *block, sampleCount start, sampleCount len,
+                             float *min, float *max, double *sumsq)
+{
+   if (len <= 0)
+      return;
+
+   samplePtr blockData = NewSamples(len, floatSample);
+   block->ReadData(blockData, floatSample, start, len);
+
+   for( int i = 0; i < len; i++ )
+   {
+      float sample = ((float*)blockData)[i];
+
+      if( sample > *max )
+         *max = sample;
+      if( sample < *min )
+         *min = sample;
+      *sumsq += (sample*sample);
+   }
+
+   DeleteSamples(blockData);
+}
+
 /// Retrieves the minimum, maximum, and maximum RMS of the
 /// specified sample data in this block.
 ///
+/// Every 256-sample summary frame that lies entirely inside the region
+/// is answered from the summary data; samples are only read for the
+/// partial frames at either end.
+///
 /// @param start The offset in this block where the region should begin
 /// @param len   The number of samples to include in the region
 /// @param *outMin A pointer to where the minimum value for this region
@@ -384,26 +616,49 @@ void BlockFile::FixSummary(void *data)
 void BlockFile::GetMinMax(sampleCount start, sampleCount len,
                   float *outMin, float *outMax, float *outRMS)
 {
-   // TODO: actually use summaries
-   samplePtr blockData = NewSamples(len, floatSample);
-   this->ReadData(blockData, floatSample, start, len);
-
    float min = FLT_MAX;
    float max = -FLT_MAX;
-   float sumsq = 0;
+   double sumsq = 0;
+
+   // Whole summary frames covered by the region.  The last frame of the
+   // block may be short; it counts as whole if the region runs to the end.
+   sampleCount frame0 = (start + 255) / 256;
+   sampleCount frame1 = (start + len) / 256;
+   if (start + len >= mLen)
+      frame1 = (mLen + 255) / 256;
+
+   // Two-field (legacy) summaries have no RMS, so they can't be used here.
+   if (frame1 > frame0 &&
+       mSummaryInfo.fields == 3 && IsSummaryAvailable()) {
+      sampleCount frames = frame1 - frame0;
+      float *summary = new float[frames * 3];
+      Read256(summary, frame0, frames);
+
+      for (sampleCount i = 0; i < frames; i++) {
+         sampleCount frameLen = mLen - (frame0 + i) * 256;
+         if (frameLen > 256)
+            frameLen = 256;
+
+         if (summary[3 * i] < min)
+            min = summary[3 * i];
+         if (summary[3 * i + 1] > max)
+            max = summary[3 * i + 1];
+         sumsq += summary[3 * i + 2] * summary[3 * i + 2] * frameLen;
+      }
 
-   for( int i = 0; i < len; i++ )
-   {
-      float sample = ((float*)blockData)[i];
+      delete[] summary;
 
-      if( sample > max )
-         max = sample;
-      if( sample < min )
-         min = sample;
-      sumsq += (sample*sample);
-   }
+      sampleCount summaryEnd = frame1 * 256;
+      if (summaryEnd > mLen)
+         summaryEnd = mLen;
 
-   DeleteSamples(blockData);
+      AccumulateMinMax(this, start, frame0 * 256 - start,
+                       &min, &max, &sumsq);
+      AccumulateMinMax(this, summaryEnd, start + len - summaryEnd,
+                       &min, &max, &sumsq);
+   }
+   else
+      AccumulateMinMax(this, start, len, &min, &max, &sumsq);
 
    *outMin = min;
    *outMax = max;
@@ -427,6 +682,128 @@ void BlockFile::GetMinMax(float *outMin, float *outMax, float *outRMS)
    *outRMS = mRMS;
 }
 
+/// Retrieves the exact aggregate statistics of this entire block.  These
+/// are computed along with the summary when the block is written, or by
+/// reading the block once if it was loaded from disk.
+///
+/// @param *outStats Where the statistics should be stored
+/// @return false if the audio data isn't available yet (for OD)
+bool BlockFile::GetStats(SampleStats *outStats)
+{
+   if (GetCachedStats(outStats))
+      return true;
+
+   if (!IsDataAvailable())
+      return false;
+
+   // Read without holding the lock; if another thread gets there
+   // first it finds the same numbers
+   samplePtr blockData = NewSamples(mLen, floatSample);
+   this->ReadData(blockData, floatSample, 0, mLen);
+
+   outStats->Clear();
+   outStats->Accumulate((float *)blockData, mLen);
+
+   DeleteSamples(blockData);
+
+   mStatsMutex.Lock();
+   mStats = *outStats;
+   mStatsValid = true;
+   mStatsMutex.Unlock();
+
+   return true;
+}
+
+/// Retrieves the statistics of this entire block if they have been
+/// computed or restored already, without reading it.
+///
+/// @param *outStats Where the statistics should be stored
+/// @return false if they aren't known
+bool BlockFile::GetCachedStats(SampleStats *outStats)
+{
+   mStatsMutex.Lock();
+   bool valid = mStatsValid;
+   if (valid)
+      *outStats = mStats;
+   mStatsMutex.Unlock();
+
+   return valid;
+}
+
+/// Passes on the statistics of this block, if known, to a copy of it.
+///
+/// @param dest The new block, holding the same audio
+void BlockFile::CopyStats(BlockFile *dest)
+{
+   SampleStats stats;
+   if (GetCachedStats(&stats))
+      dest->RestoreStats(stats.sum, stats.sumsq, stats.clipped);
+}
+
+/// Restores the sums saved with the project.  The extremes are the
+/// block's own.
+///
+/// @param sum     Sum of the block's samples
+/// @param sumsq   Sum of their squares
+/// @param clipped How many are at or beyond full scale
+void BlockFile::RestoreStats(double sum, double sumsq, sampleCount clipped)
+{
+   mStatsMutex.Lock();
+   mStats.count = mLen;
+   mStats.sum = sum;
+   mStats.sumsq = sumsq;
+   mStats.min = mMin;
+   mStats.max = mMax;
+   mStats.clipped = clipped;
+   mStatsValid = true;
+   mStatsMutex.Unlock();
+}
+
+/// Writes the "sum", "sumsq" and "clipped" attributes that
+/// RestoreStats() takes back, if the statistics are known.  Derived
+/// classes call this from SaveXML().
+void BlockFile::SaveStatsXML(XMLWriter &xmlFile)
+{
+   mStatsMutex.Lock();
+   bool valid = mStatsValid;
+   SampleStats stats = mStats;
+   mStatsMutex.Unlock();
+
+   if (!valid)
+      return;
+
+   // Enough digits that the sums read back exactly, with a point
+   // whatever the locale, as Internat::ToString() does
+   wxString sum = wxString::Format(wxT("%.17g"), stats.sum);
+   wxString sumsq = wxString::Format(wxT("%.17g"), stats.sumsq);
+   sum.Replace(wxString(Internat::GetDecimalSeparator()), wxT("."));
+   sumsq.Replace(wxString(Internat::GetDecimalSeparator()), wxT("."));
+
+   xmlFile.WriteAttr(wxT("sum"), sum);
+   xmlFile.WriteAttr(wxT("sumsq"), sumsq);
+   xmlFile.WriteAttr(wxT("clipped"), stats.clipped);
+}
+
+/// Retrieves the exact aggregate statistics of the specified region
+/// of this block.
+///
+/// @param start The offset in this block where the region should begin
+/// @param len   The number of samples to include in the region
+/// @param *outStats Where the statistics should be stored
+void BlockFile::GetStats(sampleCount start, sampleCount len,
+                         SampleStats *outStats)
+{
+   outStats->Clear();
+
+   if (start == 0 && len == mLen && GetStats(outStats))
+      return;
+
+   samplePtr blockData = NewSamples(len, floatSample);
+   this->ReadData(blockData, floatSample, start, len);
+   outStats->Accumulate((float *)blockData, len);
+   DeleteSamples(blockData);
+}
+
 /// Retrieves a portion of the 256-byte summary buffer from this BlockFile.  This
 /// data provides information about the minimum value, the maximum
 /// value, and the maximum RMS value for every group of 256 samples in the
@@ -441,14 +818,19 @@ bool BlockFile::Read256(float *buffer,
 {
    wxASSERT(start >= 0);
 
-   char *summary = new char[mSummaryInfo.totalSummaryBytes];
-   this->ReadSummary(summary);
-
    if (start+len > mSummaryInfo.frames256)
       len = mSummaryInfo.frames256 - start;
+   if (len <= 0)
+      return true;
+
+   // Only read the frames asked for
+   int bytes = len * mSummaryInfo.bytesPerFrame;
+   char *summary = new char[bytes];
+   this->ReadSummaryPart(summary,
+                         mSummaryInfo.offset256 + start * mSummaryInfo.bytesPerFrame,
+                         bytes);
 
-   CopySamples(summary + mSummaryInfo.offset256 + (start * mSummaryInfo.bytesPerFrame),
-               mSummaryInfo.format,
+   CopySamples(summary, mSummaryInfo.format,
                (samplePtr)buffer, floatSample, len * mSummaryInfo.fields);
 
    if (mSummaryInfo.fields == 2) {
@@ -480,15 +862,18 @@ bool BlockFile::Read64K(float *buffer,
 {
    wxASSERT(start >= 0);
 
-   char *summary = new char[mSummaryInfo.totalSummaryBytes];
-   this->ReadSummary(summary);
-
    if (start+len > mSummaryInfo.frames64K)
       len = mSummaryInfo.frames64K - start;
+   if (len <= 0)
+      return true;
 
-   CopySamples(summary + mSummaryInfo.offset64K +
-               (start * mSummaryInfo.bytesPerFrame),
-               mSummaryInfo.format,
+   int bytes = len * mSummaryInfo.bytesPerFrame;
+   char *summary = new char[bytes];
+   this->ReadSummaryPart(summary,
+                         mSummaryInfo.offset64K + start * mSummaryInfo.bytesPerFrame,
+                         bytes);
+
+   CopySamples(summary, mSummaryInfo.format,
                (samplePtr)buffer, floatSample, len*mSummaryInfo.fields);
 
    if (mSummaryInfo.fields == 2) {
@@ -585,6 +970,7 @@ void AliasBlockFile::WriteSummary()
                                             floatSample);
    summaryFile.Write(summaryData, mSummaryInfo.totalSummaryBytes);
 
+   delete[] (char *)summaryData;
    DeleteSamples(sampleData);
 }
 
@@ -600,14 +986,13 @@ AliasBlockFile::~AliasBlockFile()
 bool AliasBlockFile::ReadSummary(void *data)
 {
    wxFFile summaryFile(mFileName.GetFullPath(), wxT("rb"));
-   wxLogNull *silence=0;
-   if(mSilentLog)silence= new wxLogNull();
+   BlockFileSilencer silence(mSilentLog);
 
    if( !summaryFile.IsOpened() ){
 
       // new model; we need to return valid data
       memset(data,0,(size_t)mSummaryInfo.totalSummaryBytes);
-      if(silence) delete silence;
+      silence.Release();
 
       // we silence the logging for this operation in this object
       // after first occurrence of error; it's already reported and
@@ -618,7 +1003,7 @@ bool AliasBlockFile::ReadSummary(void *data)
 
    }else mSilentLog=FALSE; // worked properly, any future error is new
 
-   if(silence) delete silence;
+   silence.Release();
 
    int read = summaryFile.Read(data, (size_t)mSummaryInfo.totalSummaryBytes);
 
@@ -627,6 +1012,32 @@ bool AliasBlockFile::ReadSummary(void *data)
    return (read == mSummaryInfo.totalSummaryBytes);
 }
 
+/// Read part of the summary of this alias block, by seeking to it in
+/// the summary file.
+bool AliasBlockFile::ReadSummaryPart(void *data, int offset, int bytes)
+{
+   wxFFile summaryFile(mFileName.GetFullPath(), wxT("rb"));
+   BlockFileSilencer silence(mSilentLog);
+
+   if( !summaryFile.IsOpened() ){
+      memset(data,0,(size_t)bytes);
+      silence.Release();
+      mSilentLog=TRUE;
+      return true;
+   }else mSilentLog=FALSE;
+
+   silence.Release();
+
+   if( !summaryFile.Seek(offset) )
+      return false;
+
+   int read = summaryFile.Read(data, (size_t)bytes);
+
+   FixSummaryPart(data, bytes / mSummaryInfo.bytesPerFrame);
+
+   return (read == bytes);
+}
+
 /// Modify this block to point at a different file.  This is generally
 /// looked down on, but it is necessary in one case: see
 /// DirManager::EnsureSafeFilename().
@@ -15,8 +15,12 @@
 #include <wx/string.h>
 #include <wx/ffile.h>
 #include <wx/filename.h>
+#include <wx/log.h>
+
+#include <math.h>
 
 #include "WaveTrack.h"
+#include "ondemand/ODTaskThread.h"
 
 #include "xml/XMLTagHandler.h"
 #include "xml/XMLWriter.h"
@@ -38,6 +42,48 @@ class SummaryInfo {
 
 
 
+/// Exact running aggregates over a range of samples.  Unlike the
+/// min/max/RMS summaries these are kept as plain sums, so the
+/// statistics of adjacent ranges can be combined without error.
+class SampleStats {
+ public:
+   SampleStats();
+
+   void Clear();
+   /// Folds the statistics of another (disjoint) range into this one
+   void Add(const SampleStats &other);
+   /// Folds a buffer of samples into this one
+   void Accumulate(const float *buffer, sampleCount len);
+
+   double GetMean() const { return count > 0 ? sum / count : 0.0; }
+   double GetRMS() const { return count > 0 ? sqrt(sumsq / count) : 0.0; }
+
+   sampleCount count;
+   double      sum;
+   double      sumsq;
+   float       min;
+   float       max;
+   sampleCount clipped; /* samples at or beyond full scale */
+};
+
+/// Switches wxWidgets logging off, if asked, while a block file whose
+/// disk file went missing before is opened again.  wxLogNull turns logging
+/// off for the whole process, not just the calling thread, and blocks are
+/// read on several threads at once (playback, on-demand loading, the track
+/// panel's prefetch).  Two wxLogNulls ending out of order would leave
+/// logging off for good, so the silenced opens take turns.
+class BlockFileSilencer {
+ public:
+   BlockFileSilencer(bool silent);
+   ~BlockFileSilencer() { Release(); }
+
+   /// Logging is back on from here, rather than at the end of the scope
+   void Release();
+
+ private:
+   wxLogNull *mLogNull;
+};
+
 class BlockFile {
  public:
 
@@ -47,8 +93,6 @@ class BlockFile {
    BlockFile(wxFileName fileName, sampleCount samples);
    virtual ~BlockFile();
 
-   static void Deinit();
-
    // Reading
 
    /// Retrieves audio data from this BlockFile
@@ -77,6 +121,11 @@ class BlockFile {
    virtual sampleCount GetLength() { return mLen; }
    virtual void SetLength(const sampleCount newLen) { mLen = newLen; }
 
+   /// A number that no other BlockFile made in this session has, for
+   /// caches of things computed from a block's audio.  Unlike the
+   /// BlockFile's address, it is never reused after the block is deleted.
+   sampleCount GetSerial() const { return mSerial; }
+
    /// Locks this BlockFile, to prevent it from being moved
    virtual void Lock();
    /// Unlock this BlockFile, allowing it to be moved
@@ -89,6 +138,22 @@ class BlockFile {
                           float *outMin, float *outMax, float *outRMS);
    /// Gets extreme values for the entire block
    virtual void GetMinMax(float *outMin, float *outMax, float *outRMS);
+   /// Gets sum, sum of squares, extremes and clip count for the
+   /// entire block.  Returns false if the audio isn't available yet.
+   virtual bool GetStats(SampleStats *outStats);
+   /// Gets them only if they are already known, without reading the
+   /// block.  Returns false if they aren't.
+   bool GetCachedStats(SampleStats *outStats);
+   /// Gets sum, sum of squares, extremes and clip count for the
+   /// specified region
+   virtual void GetStats(sampleCount start, sampleCount len,
+                         SampleStats *outStats);
+   /// Takes statistics saved in a project by SaveStatsXML, so that the
+   /// block needn't be read to answer GetStats
+   void RestoreStats(double sum, double sumsq, sampleCount clipped);
+   /// Gives a copy of this block (see Copy()) the statistics already
+   /// known for this one
+   void CopyStats(BlockFile *dest);
    /// Returns the 256 byte summary data block
    virtual bool Read256(float *buffer, sampleCount start, sampleCount len);
    /// Returns the 64K summary data block
@@ -126,7 +191,9 @@ class BlockFile {
    ///Override this in case it needs special treatment
    virtual void CloseLock(){Lock();}
 
-   /// Prevents a read on other threads.  The basic blockfile runs on only one thread, so does nothing.
+   /// Prevents a read on other threads.  The basic blockfile's data never
+   /// changes once written, so reads on several threads at once need no
+   /// lock, and this does nothing; see BlockFileSilencer for the logging.
    virtual void LockRead(){}
    /// Allows reading on other threads.
    virtual void UnlockRead(){}
@@ -148,24 +215,41 @@ class BlockFile {
    /// Calculate summary data for the given sample data
    virtual void *CalcSummary(samplePtr buffer, sampleCount len,
                              sampleFormat format);
+   /// Fill in summary frames from float sample data
+   void CalcSummaryFromBuffer(const float *fbuffer, sampleCount len,
+                              float *summary256, float *summary64K);
    /// Read the summary section of the file.  Derived classes implement.
    virtual bool ReadSummary(void *data) = 0;
+   /// Read whole summary frames: bytes [offset, offset+bytes) of the
+   /// summary section.  The default reads the whole summary; derived
+   /// classes that can seek override it.
+   virtual bool ReadSummaryPart(void *data, int offset, int bytes);
 
    /// Byte-swap the summary data, in case it was saved by a system
    /// on a different platform
    virtual void FixSummary(void *data);
+   /// Byte-swap summary frames read by ReadSummaryPart, if need be
+   void FixSummaryPart(void *data, int frames);
+
+   /// Writes the block's statistics as attributes of its XML tag,
+   /// if they are known
+   void SaveStatsXML(XMLWriter &xmlFile);
 
  private:
    int mLockCount;
    int mRefCount;
-
-   static char *fullSummary;
+   sampleCount mSerial;
 
  protected:
    wxFileName mFileName;
    sampleCount mLen;
    SummaryInfo mSummaryInfo;
    float mMin, mMax, mRMS;
+   // Blocks are shared between sequences and summarized on OD threads,
+   // so these are only touched under mStatsMutex
+   SampleStats mStats;
+   bool mStatsValid;
+   ODLock mStatsMutex;
    bool mSilentLog;
 };
 
@@ -218,6 +302,8 @@ class AliasBlockFile : public BlockFile
    virtual void WriteSummary();
    /// Read the summary into a buffer
    virtual bool ReadSummary(void *data);
+   /// Read part of the summary into a buffer
+   virtual bool ReadSummaryPart(void *data, int offset, int bytes);
 
    wxFileName  mAliasedFileName;
    sampleCount mAliasStart;
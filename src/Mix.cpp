@@ -291,8 +291,10 @@ Mixer::Mixer(int numInputTracks, WaveTrack **inputTracks,
          mResample[i] = new Resample(mHighQuality,
                                       factor / timeTrack->GetRangeUpper(),
                                       factor / timeTrack->GetRangeLower());
-      } else {
+      } else if (mInputTrack[i]->GetRate() != mRate) {
          mResample[i] = new Resample(mHighQuality, factor, factor); // constant rate resampling
+      } else {
+         mResample[i] = NULL; // mixed by MixSameRate(), no converter needed
       }
       mSampleQueue[i] = new float[mQueueMaxLen];
       mQueueStart[i] = 0;
@@ -441,7 +443,11 @@ sampleCount Mixer::MixVariableRates(int *channelFlags, WaveTrack *track,
 
       sampleCount thisProcessLen = mProcessLen;
       bool last = (*queueLen < mProcessLen);
-      if (last) {
+      if (last || !mTimeTrack) {
+         // Without a time track the ratio never changes, so there is no
+         // warp factor to keep current and the (constant rate) converter
+         // can take everything that's queued; the space left in the
+         // output buffer limits how much of it is used.
          thisProcessLen = *queueLen;
       }
 
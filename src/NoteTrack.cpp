@@ -22,6 +22,7 @@
 #include "Audacity.h"
 
 #if defined(USE_MIDI)
+#include <float.h>
 #include <sstream>
 
 #define ROUND(x) ((int) ((x) + 0.5))
@@ -120,10 +121,18 @@ Track(projDirManager)
 
    mVisibleChannels = ALL_CHANNELS;
    mLastMidiPosition = 0;
+
+   mNoteIndexValid = false;
+   mNoteIndexSeq = NULL;
+   mNoteIndex = NULL;
+   mNoteIndexMaxEnd = NULL;
+   mNoteIndexLen = 0;
 }
 
 NoteTrack::~NoteTrack()
 {
+   InvalidateNoteIndex();
+
    if (mSerializationBuffer) {
       delete [] mSerializationBuffer;
    }
@@ -204,6 +213,7 @@ void NoteTrack::WarpAndTransposeNotes(double t0, double t1,
       nt->mSeq = NULL;
       delete nt; // delete the duplicate
    }
+   InvalidateNoteIndex();
    mSeq->convert_to_seconds(); // make sure time units are right
    t1 -= offset; // adjust time range to compensate for track offset
    t0 -= offset;
@@ -365,6 +375,7 @@ bool NoteTrack::LabelClick(wxRect & r, int mx, int my, bool right)
 
 void NoteTrack::SetSequence(Alg_seq_ptr seq)
 {
+   InvalidateNoteIndex();
    if (mSeq)
       delete mSeq;
 
@@ -450,6 +461,7 @@ bool NoteTrack::Cut(double t0, double t1, Track **dest){
 
    newTrack->Init(*this);
 
+   InvalidateNoteIndex();
    mSeq->convert_to_seconds();
    newTrack->mSeq = mSeq->cut(t0 - GetOffset(), len, false);
    newTrack->SetOffset(GetOffset());
@@ -492,6 +504,7 @@ bool NoteTrack::Trim(double t0, double t1)
 {
    if (t1 <= t0)
       return false;
+   InvalidateNoteIndex();
    mSeq->convert_to_seconds();
    // delete way beyond duration just in case something is out there:
    mSeq->clear(t1 - GetOffset(), mSeq->get_dur() + 10000.0, false);
@@ -509,6 +522,7 @@ bool NoteTrack::Clear(double t0, double t1)
       return false;
    double len = t1-t0;
 
+   InvalidateNoteIndex();
    mSeq->clear(t0 - GetOffset(), len, false);
 
    return true;
@@ -534,6 +548,7 @@ bool NoteTrack::Paste(double t, Track *src)
 
    if(!mSeq)
       mSeq = new Alg_seq();
+   InvalidateNoteIndex();
 
    if (other->GetOffset() > 0) {
       mSeq->convert_to_seconds();
@@ -549,6 +564,7 @@ bool NoteTrack::Paste(double t, Track *src)
 // NOT the function that handles horizontal dragging.
 bool NoteTrack::Shift(double t) // t is always seconds
 {
+   InvalidateNoteIndex();
    if (t > 0) {
       // insert an even number of measures
       mSeq->convert_to_beats();
@@ -591,6 +607,7 @@ bool NoteTrack::StretchRegion(double t0, double t1, double dur)
    t1 -= GetOffset();
    double b0 = mSeq->get_time_map()->time_to_beat(t0);
    double b1 = mSeq->get_time_map()->time_to_beat(t1);
+   InvalidateNoteIndex();
    bool result = mSeq->stretch_region(b0, b1, dur);
    if (result) {
       mSeq->convert_to_seconds();
@@ -785,6 +802,7 @@ bool NoteTrack::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
          else if (!wxStrcmp(attr, wxT("data"))) {
              std::string s(strValue.mb_str(wxConvUTF8));
              std::istringstream data(s);
+             InvalidateNoteIndex();
              mSeq = new Alg_seq(data, false);
          }
       } // while
@@ -793,6 +811,100 @@ bool NoteTrack::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
    return false;
 }
 
+void NoteTrack::InvalidateNoteIndex()
+{
+   delete[] mNoteIndex;
+   delete[] mNoteIndexMaxEnd;
+   mNoteIndex = NULL;
+   mNoteIndexMaxEnd = NULL;
+   mNoteIndexLen = 0;
+   mNoteIndexValid = false;
+}
+
+void NoteTrack::BuildNoteIndex()
+{
+   InvalidateNoteIndex();
+   if (!mSeq)
+      return;
+
+   mSeq->convert_to_seconds();
+
+   Alg_iterator iter(mSeq, false);
+   Alg_event_ptr event;
+   int count = 0;
+   iter.begin();
+   while ((event = iter.next())) {
+      if (event->is_note())
+         count++;
+   }
+   iter.end();
+
+   mNoteIndex = new Alg_note_ptr[count];
+   mNoteIndexMaxEnd = new double[count];
+
+   // The iterator gives events in time order
+   iter.begin();
+   while ((event = iter.next())) {
+      if (event->is_note())
+         mNoteIndex[mNoteIndexLen++] = (Alg_note_ptr) event;
+   }
+   iter.end();
+   BuildNoteTree(0, mNoteIndexLen);
+
+   mNoteIndexSeq = mSeq;
+   mNoteIndexValid = true;
+}
+
+// Fills in mNoteIndexMaxEnd for the subtree of notes lo up to hi, and
+// returns the latest end time among them
+double NoteTrack::BuildNoteTree(int lo, int hi)
+{
+   if (lo >= hi)
+      return -DBL_MAX;
+
+   int mid = (lo + hi) / 2;
+   double maxEnd = mNoteIndex[mid]->time + mNoteIndex[mid]->dur;
+   double left = BuildNoteTree(lo, mid);
+   double right = BuildNoteTree(mid + 1, hi);
+   if (left > maxEnd)
+      maxEnd = left;
+   if (right > maxEnd)
+      maxEnd = right;
+   mNoteIndexMaxEnd[mid] = maxEnd;
+   return maxEnd;
+}
+
+void NoteTrack::FindNotes(double t0, double t1, std::vector<Alg_note_ptr> &notes)
+{
+   if (!mNoteIndexValid || mNoteIndexSeq != mSeq)
+      BuildNoteIndex();
+
+   notes.clear();
+   FindNotes(0, mNoteIndexLen, t0, t1, notes);
+}
+
+void NoteTrack::FindNotes(int lo, int hi, double t0, double t1,
+                          std::vector<Alg_note_ptr> &notes)
+{
+   while (lo < hi) {
+      int mid = (lo + hi) / 2;
+      // Everything under mid is over by t0
+      if (mNoteIndexMaxEnd[mid] <= t0)
+         return;
+
+      FindNotes(lo, mid, t0, t1, notes);
+
+      // mid, and everything after it, starts at or after t1
+      Alg_note_ptr note = mNoteIndex[mid];
+      if (note->time >= t1)
+         return;
+      if (note->time + note->dur > t0)
+         notes.push_back(note);
+
+      lo = mid + 1;
+   }
+}
+
 XMLTagHandler *NoteTrack::HandleXMLChild(const wxChar * WXUNUSED(tag))
 {
    return NULL;
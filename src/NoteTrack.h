@@ -11,6 +11,7 @@
 #ifndef __AUDACITY_NOTETRACK__
 #define __AUDACITY_NOTETRACK__
 
+#include <vector>
 #include <wx/string.h>
 #include "Audacity.h"
 #include "Experimental.h"
@@ -183,7 +184,18 @@ class AUDACITY_DLL_API NoteTrack:public Track {
    void SetVisibleChan(int c) { mVisibleChannels |= CHANNEL_BIT(c); }
    void ClearVisibleChan(int c) { mVisibleChannels &= ~CHANNEL_BIT(c); }
    void ToggleVisibleChan(int c) { mVisibleChannels ^= CHANNEL_BIT(c); }
+
+   // Fills notes with the notes sounding at some time after t0 and before
+   // t1 (sequence time, in seconds, without the track offset), in order of
+   // start time
+   void FindNotes(double t0, double t1, std::vector<Alg_note_ptr> &notes);
  private:
+   void BuildNoteIndex();
+   double BuildNoteTree(int lo, int hi);
+   void FindNotes(int lo, int hi, double t0, double t1,
+                  std::vector<Alg_note_ptr> &notes);
+   void InvalidateNoteIndex();
+
    Alg_seq *mSeq; // NULL means no sequence
    // when Duplicate() is called, assume that it is to put a copy
    // of the track into the undo stack or to redo/copy from the
@@ -212,6 +224,17 @@ class AUDACITY_DLL_API NoteTrack:public Track {
    int mPitchHeight;
    int mVisibleChannels; // bit set of visible channels
    int mLastMidiPosition;
+
+   // The notes of mSeq sorted by start time, read as a balanced binary
+   // tree: the root of the notes from lo up to hi is the one halfway
+   // between.  For each root, the latest end time of the notes under it,
+   // so that drawing can skip straight to the notes in view.  Thrown away
+   // by anything that edits the sequence.
+   bool mNoteIndexValid;
+   Alg_seq_ptr mNoteIndexSeq;
+   Alg_note_ptr *mNoteIndex;
+   double *mNoteIndexMaxEnd;
+   int mNoteIndexLen;
    wxRect mGainPlacementRect;
 };
 
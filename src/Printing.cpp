@@ -80,6 +80,7 @@ bool AudacityPrintout::OnPrintPage(int WXUNUSED(page))
    TrackArtist artist;
    artist.SetBackgroundBrushes(*wxWHITE_BRUSH, *wxWHITE_BRUSH,
                                *wxWHITE_PEN, *wxWHITE_PEN);
+   artist.SetWaitForSpectrum(true);
    ViewInfo viewInfo;
    viewInfo.selectedRegion = SelectedRegion();
    viewInfo.vpos = 0;
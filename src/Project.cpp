@@ -728,6 +728,7 @@ BEGIN_EVENT_TABLE(AudacityProject, wxFrame)
    //mchinen:multithreaded calls - may not be threadsafe with CommandEvent: may have to change.
    EVT_COMMAND(wxID_ANY, EVT_ODTASK_UPDATE, AudacityProject::OnODTaskUpdate)
    EVT_COMMAND(wxID_ANY, EVT_ODTASK_COMPLETE, AudacityProject::OnODTaskComplete)
+   EVT_COMMAND(wxID_ANY, EVT_SPECTRUM_COLUMNS_READY, AudacityProject::OnSpectrumColumnsReady)
 END_EVENT_TABLE()
 
 AudacityProject::AudacityProject(wxWindow * parent, wxWindowID id,
@@ -1751,6 +1752,13 @@ void AudacityProject::OnODTaskComplete(wxCommandEvent & WXUNUSED(event))
       mTrackPanel->Refresh(false);
  }
 
+//redraws the spectrograms whose columns the spectrum workers have finished.
+void AudacityProject::OnSpectrumColumnsReady(wxCommandEvent & WXUNUSED(event))
+{
+   if(mTrackPanel)
+      mTrackPanel->Refresh(false);
+}
+
 void AudacityProject::OnScroll(wxScrollEvent & WXUNUSED(event))
 {
    wxInt64 hlast = mViewInfo.sbarH;
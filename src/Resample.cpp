@@ -23,9 +23,11 @@
 
       libsoxr, written by Rob Sykes. LGPL.
 
-   Since Audacity always does resampling on mono streams that are
-   contiguous in memory, this class doesn't support multiple channels
-   or some of the other optional features of some of these resamplers.
+   Channels are converted together as interleaved frames.  libsoxr and
+   libsamplerate handle this natively (libsoxr may also spread the
+   channels over several threads); with libresample, which is mono
+   only, each channel gets its own converter.  This class doesn't
+   support some of the other optional features of these resamplers.
 
 *//*******************************************************************/
 
@@ -36,19 +38,50 @@
 
    #include "libresample.h"
 
-   Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor)
+   Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor,
+                      const int numChannels, const int maxBlockLen)
    {
       this->SetMethod(useBestMethod);
+      mNumChannels = numChannels;
+      mChannelHandles = NULL;
+      mScratchIn = NULL;
+      mScratchOut = NULL;
+      mScratchInLen = 0;
+      mScratchOutLen = 0;
       mHandle = resample_open(mMethod, dMinFactor, dMaxFactor);
       if(mHandle == NULL) {
          fprintf(stderr, "libresample doesn't support range of factors %f to %f.\n", dMinFactor, dMaxFactor);
          // FIXME: Audacity will hang after this if branch.
          return;
       }
+
+      if (mNumChannels > 1) {
+         mChannelHandles = new void*[mNumChannels];
+         mChannelHandles[0] = mHandle;
+         for (int c = 1; c < mNumChannels; c++)
+            mChannelHandles[c] = resample_open(mMethod, dMinFactor, dMaxFactor);
+
+         // Each channel is copied out of and back into the interleaved
+         // buffers through these, so Process() allocates nothing
+         mScratchInLen = maxBlockLen;
+         mScratchOutLen = (int)(maxBlockLen * dMaxFactor) + 1;
+         mScratchIn = new float[mScratchInLen];
+         mScratchOut = new float[mScratchOutLen];
+      }
    }
 
    Resample::~Resample()
    {
+      if (mChannelHandles) {
+         for (int c = 1; c < mNumChannels; c++)
+            resample_close(mChannelHandles[c]);
+         delete[] mChannelHandles;
+         mChannelHandles = NULL;
+      }
+      delete[] mScratchIn;
+      mScratchIn = NULL;
+      delete[] mScratchOut;
+      mScratchOut = NULL;
       resample_close(mHandle);
       mHandle = NULL;
    }
@@ -84,17 +117,42 @@
                          float  *outBuffer,
                          int     outBufferLen)
    {
-      return resample_process(mHandle, factor, inBuffer, inBufferLen,
-                              (int)lastFlag, inBufferUsed, outBuffer, outBufferLen);
+      if (!mChannelHandles)
+         return resample_process(mHandle, factor, inBuffer, inBufferLen,
+                                 (int)lastFlag, inBufferUsed, outBuffer, outBufferLen);
+
+      // Every channel is fed the same number of frames, so the converters
+      // stay in step and report the same counts.  No more is taken than
+      // fits the scratch buffers; the caller sees that in inBufferUsed.
+      int inLen = inBufferLen < mScratchInLen ? inBufferLen : mScratchInLen;
+      int outMax = outBufferLen < mScratchOutLen ? outBufferLen : mScratchOutLen;
+      bool last = lastFlag && inLen == inBufferLen;
+      int outLen = 0;
+
+      for (int c = 0; c < mNumChannels; c++) {
+         int i;
+         for (i = 0; i < inLen; i++)
+            mScratchIn[i] = inBuffer[i * mNumChannels + c];
+
+         outLen = resample_process(mChannelHandles[c], factor, mScratchIn, inLen,
+                                   (int)last, inBufferUsed, mScratchOut, outMax);
+
+         for (i = 0; i < outLen; i++)
+            outBuffer[i * mNumChannels + c] = mScratchOut[i];
+      }
+
+      return outLen;
    }
 
 #elif USE_LIBSAMPLERATE
 
    #include <samplerate.h>
 
-   Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor)
+   Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor,
+                      const int numChannels, const int WXUNUSED(maxBlockLen))
    {
       this->SetMethod(useBestMethod);
+      mNumChannels = numChannels;
       if (!src_is_valid_ratio (dMinFactor) || !src_is_valid_ratio (dMaxFactor)) {
          fprintf(stderr, "libsamplerate supports only resampling factors between 1/SRC_MAX_RATIO and SRC_MAX_RATIO.\n");
          // FIXME: Audacity will hang after this if branch.
@@ -103,7 +161,7 @@
       }
 
       int err;
-      SRC_STATE *state = src_new(mMethod, 1, &err);
+      SRC_STATE *state = src_new(mMethod, mNumChannels, &err);
       mHandle = (void *)state;
       mShouldReset = false;
       mSamplesLeft = 0;
@@ -198,9 +256,11 @@
 
    #include <soxr.h>
 
-   Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor)
+   Resample::Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor,
+                      const int numChannels, const int WXUNUSED(maxBlockLen))
    {
       this->SetMethod(useBestMethod);
+      mNumChannels = numChannels;
       soxr_quality_spec_t q_spec;
       if (dMinFactor == dMaxFactor)
       {
@@ -212,7 +272,10 @@
          mbWantConstRateResampling = false; // variable rate resampling
          q_spec = soxr_quality_spec(SOXR_HQ, SOXR_VR);
       }
-      mHandle = (void *)soxr_create(1, dMinFactor, 1, 0, 0, &q_spec, 0);
+      // Let libsoxr decide how many threads to use on the channels
+      // (0 = automatic); a single channel gains nothing from them.
+      soxr_runtime_spec_t runtime_spec = soxr_runtime_spec(mNumChannels > 1 ? 0 : 1);
+      mHandle = (void *)soxr_create(1, dMinFactor, mNumChannels, 0, 0, &q_spec, &runtime_spec);
    }
 
    Resample::~Resample()
@@ -33,9 +33,15 @@ class Resample
    /// the fast method.
    // dMinFactor and dMaxFactor specify the range of factors for variable-rate resampling.
    // For constant-rate, pass the same value for both.
-   Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor);
+   // numChannels > 1 converts that many interleaved channels in each call;
+   // maxBlockLen is then the most frames that will be passed to Process()
+   // at a time.
+   Resample(const bool useBestMethod, const double dMinFactor, const double dMaxFactor,
+            const int numChannels = 1, const int maxBlockLen = 0);
    virtual ~Resample();
 
+   int GetNumChannels() const { return mNumChannels; }
+
    static int GetNumMethods();
    static wxString GetMethodName(int index);
 
@@ -54,8 +60,10 @@ class Resample
     * number of output samples generated is the return value of the function.
     * This function may do nothing if you don't pass a large enough output
     * buffer (i.e. there is no where to put a full block of output data)
+    * With more than one channel, both buffers are interleaved and all
+    * lengths and counts are in frames.
     @param factor The scaling factor to resample by.
-    @param inBuffer Buffer of input samples to be processed (mono)
+    @param inBuffer Buffer of input samples to be processed
     @param inBufferLen Length of the input buffer, in samples.
     @param lastFlag Flag to indicate this is the last lot of input samples and
     the buffer needs to be emptied out into the rate converter.
@@ -85,8 +93,15 @@ class Resample
 
  protected:
    int   mMethod; // resampler-specific enum for resampling method
+   int   mNumChannels;
    void* mHandle; // constant-rate or variable-rate resampler (XOR per instance)
-#if USE_LIBSAMPLERATE
+#if USE_LIBRESAMPLE
+   void** mChannelHandles; // libresample is mono only, so one per extra channel
+   float* mScratchIn;      // one channel at a time, allocated up front
+   float* mScratchOut;
+   int    mScratchInLen;
+   int    mScratchOutLen;
+#elif USE_LIBSAMPLERATE
    bool mShouldReset; // whether the resampler should be reset because lastFlag has been set previously
    int  mSamplesLeft; // number of samples left before a reset is needed
 #elif USE_LIBSOXR
@@ -33,6 +33,8 @@
 #include <float.h>
 #include <math.h>
 
+#include <vector>
+
 #include <wx/dynarray.h>
 #include <wx/intl.h>
 #include <wx/filefn.h>
@@ -50,6 +52,126 @@
 
 int Sequence::sMaxDiskBlockSize = 1048576;
 
+// The per-block SampleStats in a segment tree, so that the statistics of
+// any run of whole blocks can be found, and any block's entry replaced,
+// in O(log blocks).  Blocks whose statistics haven't been computed yet are
+// marked rather than read, and counted, so that a query can find the ones
+// in its range.
+class SeqStatsIndex {
+ public:
+   SeqStatsIndex();
+
+   int GetCount() const { return mNumBlocks; }
+
+   // Replaces block b's entry; known is false if the block's statistics
+   // aren't available without reading it
+   void Set(int b, const SampleStats &stats, bool known);
+   // Adds an entry for a block after the last
+   void Append(const SampleStats &stats, bool known);
+
+   // Statistics of blocks [b0, b1), which must all be known
+   void Get(int b0, int b1, SampleStats *outStats) const;
+   // The first block in [b0, b1) whose statistics aren't known, or -1
+   int FindUnknown(int b0, int b1) const;
+
+ private:
+   void Combine(int node);
+   int FindUnknown(int node, int lo, int hi, int b0, int b1) const;
+
+   int mNumBlocks;
+   int mCapacity;   // a power of two
+
+   // Node 1 is the root and node n has children 2n and 2n + 1; block b
+   // is node mCapacity + b
+   std::vector<SampleStats> mStats;
+   std::vector<int> mUnknown;
+};
+
+SeqStatsIndex::SeqStatsIndex():
+   mNumBlocks(0),
+   mCapacity(1),
+   mStats(2),
+   mUnknown(2, 0)
+{
+}
+
+void SeqStatsIndex::Combine(int node)
+{
+   mStats[node] = mStats[2 * node];
+   mStats[node].Add(mStats[2 * node + 1]);
+   mUnknown[node] = mUnknown[2 * node] + mUnknown[2 * node + 1];
+}
+
+void SeqStatsIndex::Set(int b, const SampleStats &stats, bool known)
+{
+   int node = mCapacity + b;
+   if (known)
+      mStats[node] = stats;
+   else
+      mStats[node].Clear();
+   mUnknown[node] = known ? 0 : 1;
+
+   for (node /= 2; node >= 1; node /= 2)
+      Combine(node);
+}
+
+void SeqStatsIndex::Append(const SampleStats &stats, bool known)
+{
+   if (mNumBlocks == mCapacity) {
+      // Double the capacity, keeping the leaves
+      int capacity = 2 * mCapacity;
+      std::vector<SampleStats> newStats(2 * capacity);
+      std::vector<int> newUnknown(2 * capacity, 0);
+      for (int b = 0; b < mNumBlocks; b++) {
+         newStats[capacity + b] = mStats[mCapacity + b];
+         newUnknown[capacity + b] = mUnknown[mCapacity + b];
+      }
+      mStats.swap(newStats);
+      mUnknown.swap(newUnknown);
+      mCapacity = capacity;
+      for (int node = mCapacity - 1; node >= 1; node--)
+         Combine(node);
+   }
+
+   Set(mNumBlocks++, stats, known);
+}
+
+void SeqStatsIndex::Get(int b0, int b1, SampleStats *outStats) const
+{
+   outStats->Clear();
+
+   int lo = mCapacity + b0;
+   int hi = mCapacity + b1;
+   while (lo < hi) {
+      if (lo & 1)
+         outStats->Add(mStats[lo++]);
+      if (hi & 1)
+         outStats->Add(mStats[--hi]);
+      lo /= 2;
+      hi /= 2;
+   }
+}
+
+int SeqStatsIndex::FindUnknown(int b0, int b1) const
+{
+   return FindUnknown(1, 0, mCapacity, b0, b1);
+}
+
+// The first unknown block in [b0, b1) under node, which covers [lo, hi)
+int SeqStatsIndex::FindUnknown(int node, int lo, int hi, int b0, int b1) const
+{
+   if (hi <= b0 || lo >= b1 || mUnknown[node] == 0)
+      return -1;
+   if (hi - lo == 1)
+      return lo;
+
+   int mid = (lo + hi) / 2;
+   int b = FindUnknown(2 * node, lo, mid, b0, b1);
+   if (b < 0)
+      b = FindUnknown(2 * node + 1, mid, hi, b0, b1);
+   return b;
+}
+
 // Sequence methods
 Sequence::Sequence(DirManager * projDirManager, sampleFormat format)
 {
@@ -62,6 +184,7 @@ Sequence::Sequence(DirManager * projDirManager, sampleFormat format)
    mMinSamples = sMaxDiskBlockSize / SAMPLE_SIZE(mSampleFormat) / 2;
    mMaxSamples = mMinSamples * 2;
    mErrorOpening = false;
+   mStatsIndex = NULL;
 }
 
 Sequence::Sequence(const Sequence &orig, DirManager *projDirManager)
@@ -77,6 +200,7 @@ Sequence::Sequence(const Sequence &orig, DirManager *projDirManager)
    mMaxSamples = orig.mMaxSamples;
    mMinSamples = orig.mMinSamples;
    mErrorOpening = false;
+   mStatsIndex = NULL;
 
    mBlock = new BlockArray();
 
@@ -94,6 +218,7 @@ Sequence::~Sequence()
    }
 
    delete mBlock;
+   delete mStatsIndex;
    mDirManager->Deref();
 }
 
@@ -147,6 +272,8 @@ bool Sequence::SetSampleFormat(sampleFormat format)
 
 bool Sequence::ConvertToSampleFormat(sampleFormat format, bool* pbChanged)
 {
+   InvalidateStatistics();
+
    wxASSERT(pbChanged);
    *pbChanged = false;
 
@@ -398,6 +525,137 @@ bool Sequence::GetRMS(sampleCount start, sampleCount len,
    return true;
 }
 
+bool Sequence::GetStatistics(sampleCount start, sampleCount len,
+                             SampleStats * outStats) const
+{
+   outStats->Clear();
+
+   if (len <= 0 || mBlock->GetCount() == 0)
+      return true;
+
+   int block0 = FindBlock(start);
+   int block1 = FindBlock(start + len - 1);
+
+   SeqBlock *b0 = mBlock->Item(block0);
+   SeqBlock *b1 = mBlock->Item(block1);
+
+   // Whole blocks come from the index
+   int whole0 = (start == b0->start) ? block0 : block0 + 1;
+   int whole1 = (start + len == b1->start + b1->f->GetLength()) ?
+      block1 + 1 : block1;
+
+   // Partial blocks at either end are read, so their audio must be there
+   if ((whole0 != block0 && !b0->f->IsDataAvailable()) ||
+       (whole1 == block1 && !b1->f->IsDataAvailable()))
+      return false;
+
+   if (block0 == block1 && (whole0 != block0 || whole1 != block1 + 1)) {
+      // Part of one block
+      b0->f->GetStats(start - b0->start, len, outStats);
+      return true;
+   }
+
+   if (whole0 < whole1) {
+      mStatsIndexMutex.Lock();
+      BuildStatistics();
+
+      // Blocks whose statistics were never computed (from old projects,
+      // or decoded on demand) are read now, but only those in the range
+      int b;
+      while ((b = mStatsIndex->FindUnknown(whole0, whole1)) >= 0) {
+         SampleStats stats;
+         if (!mBlock->Item(b)->f->GetStats(&stats)) {
+            mStatsIndexMutex.Unlock();
+            return false;
+         }
+         mStatsIndex->Set(b, stats, true);
+      }
+
+      mStatsIndex->Get(whole0, whole1, outStats);
+      mStatsIndexMutex.Unlock();
+   }
+
+   SampleStats partial;
+
+   if (whole0 != block0) {
+      b0->f->GetStats(start - b0->start,
+                      b0->start + b0->f->GetLength() - start, &partial);
+      outStats->Add(partial);
+   }
+
+   if (whole1 == block1) {
+      b1->f->GetStats(0, start + len - b1->start, &partial);
+      outStats->Add(partial);
+   }
+
+   return true;
+}
+
+bool Sequence::GetContentKey(sampleCount start, sampleCount len,
+                             std::vector<sampleCount> &key) const
+{
+   if (start < 0 || len <= 0 || start + len > mNumSamples)
+      return false;
+
+   int b = FindBlock(start);
+   key.push_back(start - mBlock->Item(b)->start);
+   key.push_back(len);
+
+   sampleCount end = start + len;
+   for (; b < (int)mBlock->GetCount() && mBlock->Item(b)->start < end; b++) {
+      BlockFile *f = mBlock->Item(b)->f;
+      if (!f->IsDataAvailable())
+         return false;
+      key.push_back(f->GetSerial());
+   }
+
+   return true;
+}
+
+void Sequence::InvalidateStatistics()
+{
+   mStatsIndexMutex.Lock();
+   delete mStatsIndex;
+   mStatsIndex = NULL;
+   mStatsIndexMutex.Unlock();
+}
+
+// Brings the index entries of blocks [b0, b1) up to date after those
+// blocks were replaced or appended
+void Sequence::UpdateStatistics(int b0, int b1)
+{
+   mStatsIndexMutex.Lock();
+   if (mStatsIndex) {
+      for (int b = b0; b < b1; b++) {
+         SampleStats stats;
+         bool known = mBlock->Item(b)->f->GetCachedStats(&stats);
+         if (b < mStatsIndex->GetCount())
+            mStatsIndex->Set(b, stats, known);
+         else
+            mStatsIndex->Append(stats, known);
+      }
+   }
+   mStatsIndexMutex.Unlock();
+}
+
+// Call with mStatsIndexMutex held.  Reads no blocks: those whose
+// statistics aren't known yet are left for GetStatistics() to read
+// if it needs them.
+void Sequence::BuildStatistics() const
+{
+   if (mStatsIndex)
+      return;
+
+   int numBlocks = mBlock->GetCount();
+   mStatsIndex = new SeqStatsIndex();
+
+   for (int b = 0; b < numBlocks; b++) {
+      SampleStats stats;
+      bool known = mBlock->Item(b)->f->GetCachedStats(&stats);
+      mStatsIndex->Append(stats, known);
+   }
+}
+
 bool Sequence::Copy(sampleCount s0, sampleCount s1, Sequence **dest)
 {
    *dest = 0;
@@ -453,6 +711,8 @@ bool Sequence::Copy(sampleCount s0, sampleCount s1, Sequence **dest)
 
 bool Sequence::Paste(sampleCount s, const Sequence *src)
 {
+   InvalidateStatistics();
+
    if ((s < 0) || (s > mNumSamples))
    {
       wxLogError(
@@ -737,6 +997,8 @@ bool Sequence::AppendAlias(wxString fullPath,
    mBlock->Add(newBlock);
    mNumSamples += newBlock->f->GetLength();
 
+   UpdateStatistics(mBlock->GetCount() - 1, mBlock->GetCount());
+
    return true;
 }
 
@@ -754,6 +1016,8 @@ bool Sequence::AppendCoded(wxString fName, sampleCount start,
    mBlock->Add(newBlock);
    mNumSamples += newBlock->f->GetLength();
 
+   UpdateStatistics(mBlock->GetCount() - 1, mBlock->GetCount());
+
    return true;
 }
 
@@ -779,6 +1043,8 @@ bool Sequence::AppendBlock(SeqBlock * b)
    mBlock->Add(newBlock);
    mNumSamples += newBlock->f->GetLength();
 
+   UpdateStatistics(mBlock->GetCount() - 1, mBlock->GetCount());
+
    // Don't do a consistency check here because this
    // function gets called in an inner loop
 
@@ -822,6 +1088,8 @@ sampleCount Sequence::GetBestBlockSize(sampleCount start) const
 
 bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
 {
+   InvalidateStatistics();
+
    sampleCount nValue;
 
    /* handle waveblock tag and it's attributes */
@@ -952,6 +1220,8 @@ bool Sequence::HandleXMLTag(const wxChar *tag, const wxChar **attrs)
 
 void Sequence::HandleXMLEndTag(const wxChar *tag)
 {
+   InvalidateStatistics();
+
    if (wxStrcmp(tag, wxT("sequence")) != 0)
       return;
 
@@ -1131,16 +1401,35 @@ bool Sequence::CopyWrite(samplePtr buffer, SeqBlock *b,
    // We don't ever write to an existing block; to support Undo,
    // we copy the old block entirely into memory, dereference it,
    // make the change, and then write the new block to disk.
+   //
+   // The old block stays shared with any other sequence (for example
+   // the undo history) that references it, so only the blocks that are
+   // actually touched cost any disk I/O.
 
    wxASSERT(b);
    wxASSERT(b->f->GetLength() <= mMaxSamples);
    wxASSERT(start + len <= b->f->GetLength());
 
+   // Overwriting the whole block: there is nothing of the old one to keep
+   if (start == 0 && len == b->f->GetLength()) {
+      BlockFile *oldBlockFile = b->f;
+      b->f = mDirManager->NewSimpleBlockFile(buffer, len, mSampleFormat);
+      mDirManager->Deref(oldBlockFile);
+      return true;
+   }
+
    int sampleSize = SAMPLE_SIZE(mSampleFormat);
    samplePtr newBuffer = NewSamples(mMaxSamples, mSampleFormat);
    wxASSERT(newBuffer);
 
    Read(newBuffer, mSampleFormat, b, 0, b->f->GetLength());
+
+   // If the samples are unchanged, keep sharing the old block
+   if (!memcmp(newBuffer + start*sampleSize, buffer, len*sampleSize)) {
+      DeleteSamples(newBuffer);
+      return true;
+   }
+
    memcpy(newBuffer + start*sampleSize, buffer, len*sampleSize);
 
    BlockFile *oldBlockFile = b->f;
@@ -1200,7 +1489,8 @@ bool Sequence::Set(samplePtr buffer, sampleFormat format,
       ClearSamples(silence, format, 0, mMaxSamples);
    }
 
-   int b = FindBlock(start);
+   int firstBlock = FindBlock(start);
+   int b = firstBlock;
 
    while (len) {
       int blen = mBlock->Item(b)->start + mBlock->Item(b)->f->GetLength() - start;
@@ -1244,6 +1534,9 @@ bool Sequence::Set(samplePtr buffer, sampleFormat format,
    if (format != mSampleFormat)
       DeleteSamples(temp);
 
+   // Set() replaces blocks but never moves them
+   UpdateStatistics(firstBlock, b);
+
    return ConsistencyCheck(wxT("Set"));
 }
 
@@ -1466,6 +1759,8 @@ bool Sequence::Append(samplePtr buffer, sampleFormat format,
 
    // If the last block is not full, we need to add samples to it
    int numBlocks = mBlock->GetCount();
+   // The first block whose statistics may change
+   int firstChanged = numBlocks;
    if (numBlocks > 0 && mBlock->Item(numBlocks - 1)->f->GetLength() < mMinSamples) {
       SeqBlock *lastBlock = mBlock->Item(numBlocks - 1);
       sampleCount addLen;
@@ -1499,6 +1794,7 @@ bool Sequence::Append(samplePtr buffer, sampleFormat format,
       mDirManager->Deref(lastBlock->f);
       delete lastBlock;
       mBlock->Item(numBlocks - 1) = newLastBlock;
+      firstChanged = numBlocks - 1;
 
       len -= addLen;
       mNumSamples += addLen;
@@ -1517,6 +1813,7 @@ bool Sequence::Append(samplePtr buffer, sampleFormat format,
          'in function "NewSamples()"' to be clearer.*/
       if (!temp) {
          wxMessageBox(_("Memory allocation failed -- NewSamples"));
+         UpdateStatistics(firstChanged, mBlock->GetCount());
          return false;
       }
    }
@@ -1548,6 +1845,8 @@ bool Sequence::Append(samplePtr buffer, sampleFormat format,
    if (temp)
       DeleteSamples(temp);
 
+   UpdateStatistics(firstChanged, mBlock->GetCount());
+
 // JKC: During generate we use Append again and again.
 // If generating a long sequence this test would give O(n^2)
 // performance - not good!
@@ -1585,6 +1884,8 @@ BlockArray *Sequence::Blockify(samplePtr buffer, sampleCount len)
 
 bool Sequence::Delete(sampleCount start, sampleCount len)
 {
+   InvalidateStatistics();
+
 
 
    if (len == 0)
@@ -1886,6 +2187,8 @@ void Sequence::AppendBlockFile(BlockFile* blockFile)
    mBlock->Add(w);
    mNumSamples += blockFile->GetLength();
 
+   UpdateStatistics(mBlock->GetCount() - 1, mBlock->GetCount());
+
 #ifdef VERY_SLOW_CHECKING
    ConsistencyCheck(wxT("AppendBlockFile"));
 #endif
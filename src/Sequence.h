@@ -11,6 +11,8 @@
 #ifndef __AUDACITY_SEQUENCE__
 #define __AUDACITY_SEQUENCE__
 
+#include <vector>
+
 #include <wx/string.h>
 #include <wx/dynarray.h>
 
@@ -29,6 +31,8 @@ typedef wxLongLong_t sampleCount; /** < A native 64-bit integer type, because
 
 class BlockFile;
 class DirManager;
+class SampleStats;
+class SeqStatsIndex;
 
 // This is an internal data structure!  For advanced use only.
 class SeqBlock {
@@ -151,6 +155,21 @@ class Sequence: public XMLTagHandler {
                   float * min, float * max) const;
    bool GetRMS(sampleCount start, sampleCount len,
                   float * outRMS) const;
+   // Exact sum, sum of squares, extremes and clip count over a range.
+   // Costs O(1) for the whole blocks plus a read of the two partial
+   // blocks at either end.  Returns false if some of the audio isn't
+   // available yet (for OD).
+   bool GetStatistics(sampleCount start, sampleCount len,
+                      SampleStats * outStats) const;
+
+   // Identifies the audio in a range, for caches of things computed from
+   // it: appends to key the offset of start in its block, len, and the
+   // serial number of every block file the range touches.  The same key
+   // means the same audio, wherever an edit has since moved it.  Returns
+   // false if some of the audio isn't available yet (for OD), or the
+   // range is outside the sequence.
+   bool GetContentKey(sampleCount start, sampleCount len,
+                      std::vector<sampleCount> &key) const;
 
    //
    // Getting block size information
@@ -194,6 +213,14 @@ class Sequence: public XMLTagHandler {
 
    bool          mErrorOpening;
 
+   // Per-block aggregates backing GetStatistics().  Set() and the Append
+   // methods update the entries of the blocks they write; other edits
+   // throw it away, and it is rebuilt from the blocks' cached statistics
+   // on demand, under mStatsIndexMutex since that happens inside a const
+   // method.
+   mutable SeqStatsIndex *mStatsIndex;
+   mutable ODLock mStatsIndexMutex;
+
    ///To block the Delete() method against the ODCalcSummaryTask::Update() method
    ODLock   mDeleteUpdateMutex;
 
@@ -203,6 +230,10 @@ class Sequence: public XMLTagHandler {
 
    void CalcSummaryInfo();
 
+   void InvalidateStatistics();
+   void UpdateStatistics(int b0, int b1);
+   void BuildStatistics() const;
+
    int FindBlock(sampleCount pos) const;
    int FindBlock(sampleCount pos, sampleCount lo,
                  sampleCount guess, sampleCount hi) const;
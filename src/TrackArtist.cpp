@@ -150,6 +150,7 @@ audio tracks.
 #include <math.h>
 #include <float.h>
 #include <limits>
+#include <map>
 
 #include <wx/brush.h>
 #include <wx/colour.h>
@@ -160,6 +161,7 @@ audio tracks.
 #include <wx/pen.h>
 #include <wx/log.h>
 #include <wx/datetime.h>
+#include <wx/thread.h>
 
 #ifdef USE_MIDI
 #include "NoteTrack.h"
@@ -173,6 +175,7 @@ audio tracks.
 #include "LabelTrack.h"
 #include "TimeTrack.h"
 #include "Prefs.h"
+#include "prefs/SpectrumPrefs.h"
 #include "Sequence.h"
 #include "Spectrum.h"
 #include "ViewInfo.h"
@@ -221,6 +224,309 @@ int TrackArtist::GetBottom(NoteTrack *t, const wxRect &r)
 */
 #endif // USE_MIDI
 
+/// Where DrawWaveformBackground() and DrawMinMaxRMS() put their pixels.
+/// Coordinates are those of the wxDC; lines are vertical or horizontal and,
+/// as with AColor::Line(), include both end points.
+class WaveformPainter
+{
+ public:
+   virtual ~WaveformPainter() {}
+   virtual void Rectangle(const wxColour &colour, int x, int y, int w, int h) = 0;
+   virtual void Line(const wxColour &colour, int x1, int y1, int x2, int y2) = 0;
+   virtual void Point(const wxColour &colour, int x, int y) = 0;
+};
+
+/// Paints straight onto the wxDC, one call per shape.  Most shapes are the
+/// same colour as the one before, so the pen and brush are only remade and
+/// selected when the colour changes.
+class DCWaveformPainter : public WaveformPainter
+{
+ public:
+   DCWaveformPainter(wxDC &dc)
+      : mDC(dc), mPenSelected(false), mBrushSelected(false),
+        mTransparentPen(false)
+   {
+   }
+
+   virtual void Rectangle(const wxColour &colour, int x, int y, int w, int h)
+   {
+      if (!mTransparentPen) {
+         mDC.SetPen(*wxTRANSPARENT_PEN);
+         mTransparentPen = true;
+         mPenSelected = false;
+      }
+      if (!mBrushSelected || mBrushColour != colour) {
+         mBrush = wxBrush(colour);
+         mBrushColour = colour;
+         mDC.SetBrush(mBrush);
+         mBrushSelected = true;
+      }
+      mDC.DrawRectangle(x, y, w, h);
+   }
+
+   virtual void Line(const wxColour &colour, int x1, int y1, int x2, int y2)
+   {
+      SelectPen(colour);
+      AColor::Line(mDC, x1, y1, x2, y2);
+   }
+
+   virtual void Point(const wxColour &colour, int x, int y)
+   {
+      SelectPen(colour);
+      mDC.DrawPoint(x, y);
+   }
+
+ private:
+   void SelectPen(const wxColour &colour)
+   {
+      if (mPenSelected && mPenColour == colour)
+         return;
+      if (mPenColour != colour) {
+         mPen = wxPen(colour);
+         mPenColour = colour;
+      }
+      mDC.SetPen(mPen);
+      mPenSelected = true;
+      mTransparentPen = false;
+   }
+
+   wxDC &mDC;
+   wxPen mPen;
+   wxColour mPenColour;
+   bool mPenSelected;      // mPen is the wxDC's pen
+   wxBrush mBrush;
+   wxColour mBrushColour;
+   bool mBrushSelected;    // mBrush is the wxDC's brush
+   bool mTransparentPen;   // the wxDC's pen is wxTRANSPARENT_PEN
+};
+
+/// Fills an RGB image covering r instead, to be put on the wxDC in one
+/// blit.  A waveform is a few shapes in every pixel column, and going
+/// through the wxDC for each of them was most of the cost of drawing it.
+class RasterWaveformPainter : public WaveformPainter
+{
+ public:
+   /// An empty r makes a painter that is never used, so that one can be
+   /// declared whether or not it is wanted
+   RasterWaveformPainter(const wxRect &r)
+      : mRect(r)
+   {
+      mData = NULL;
+      if (r.width > 0 && r.height > 0) {
+         mImage.Create(r.width, r.height, false);
+         mData = mImage.GetData();
+      }
+   }
+
+   virtual void Rectangle(const wxColour &colour, int x, int y, int w, int h)
+   {
+      int x0 = wxMax(x - mRect.x, 0), x1 = wxMin(x - mRect.x + w, mRect.width);
+      int y0 = wxMax(y - mRect.y, 0), y1 = wxMin(y - mRect.y + h, mRect.height);
+      if (x0 >= x1)
+         return;
+      for (int yy = y0; yy < y1; yy++) {
+         unsigned char *p = mData + 3 * (yy * mRect.width + x0);
+         for (int xx = x0; xx < x1; xx++, p += 3) {
+            p[0] = colour.Red();
+            p[1] = colour.Green();
+            p[2] = colour.Blue();
+         }
+      }
+   }
+
+   virtual void Line(const wxColour &colour, int x1, int y1, int x2, int y2)
+   {
+      Rectangle(colour, wxMin(x1, x2), wxMin(y1, y2),
+                abs(x2 - x1) + 1, abs(y2 - y1) + 1);
+   }
+
+   virtual void Point(const wxColour &colour, int x, int y)
+   {
+      Rectangle(colour, x, y, 1, 1);
+   }
+
+   void Blit(wxDC &dc)
+   {
+      dc.DrawBitmap(wxBitmap(mImage), mRect.x, mRect.y, false);
+   }
+
+ private:
+   wxRect mRect;
+   wxImage mImage;
+   unsigned char *mData;
+};
+
+/// Which part of a track rectangle r shows a clip, and the times at its
+/// edges.  DrawClipWaveform(), DrawClipSpectrum() and the prefetch threads
+/// all work these out here, so that they ask the clip for the same columns.
+struct ClipParameters
+{
+   ClipParameters(WaveClip *clip, const wxRect &r, const ViewInfo *viewInfo);
+
+   double tstep;     // seconds per pixel
+   double tpre;      // offset corrected time of left edge of display
+   double tpost;     // offset corrected time of right edge of display
+   double t0;        // first time shown, no earlier than the clip's start
+   double t1;        // last time shown, no later than the clip's end
+   bool showIndividualSamples;
+   wxRect mid;       // the part of r showing the clip; may be empty
+};
+
+ClipParameters::ClipParameters(WaveClip *clip, const wxRect &r,
+                               const ViewInfo *viewInfo)
+{
+   double pps = viewInfo->zoom;     //points-per-second--the zoom level
+   double rate = clip->GetRate();
+   double sps = 1./rate;            //seconds-per-sample
+   double trackLen = clip->GetEndTime() - clip->GetStartTime();
+
+   tstep = 1.0 / pps;
+   tpre = viewInfo->h - clip->GetOffset();
+   tpost = tpre + (r.width * tstep);
+
+   showIndividualSamples = (pps / rate > 0.5);   //zoomed in a lot
+
+   // Calculate actual selection bounds so that t0 > 0 and t1 < the
+   // end of the track
+   t0 = (tpre >= 0.0 ? tpre : 0.0);
+   t1 = (tpost < trackLen - sps * .99 ? tpost : trackLen - sps * .99);
+   if (showIndividualSamples) {
+      // adjustment so that the last circular point doesn't appear
+      // to be hanging off the end
+      t1 += 2. / pps;
+   }
+
+   // Make sure t1 (the right bound) is greater than 0
+   if (t1 < 0.0) {
+      t1 = 0.0;
+   }
+
+   // Make sure t1 is greater than t0
+   if (t0 > t1) {
+      t0 = t1;
+   }
+
+   // The variable "mid" will be the rectangle containing the
+   // actual waveform, as opposed to any blank area before
+   // or after the track.
+   mid = r;
+
+   // If the left edge of the track is to the right of the left
+   // edge of the display, then there's some blank area to the
+   // left of the track.  Reduce the "mid" rect by its width.
+   if (tpre < 0) {
+      int delta = r.width;
+      if (t0 < tpost) {
+         delta = (int) ((t0 - tpre) * pps);
+      }
+      mid.x += delta;
+      mid.width -= delta;
+   }
+
+   // If the right edge of the track is to the left of the the right
+   // edge of the display, then there's some blank area to the right
+   // of the track.  Reduce the "mid" rect by its width.
+   if (tpost > t1) {
+      int postX = 0;
+      if (t1 > tpre) {
+         postX = (int) ((t1 - tpre) * pps);
+      }
+      mid.width -= r.width - postX;
+   }
+}
+
+/// One wave track whose display columns should be ready before drawing.
+struct TrackPrefetch
+{
+   WaveTrack *track;
+   wxRect r;
+};
+
+/// Fills the wave caches of the clips of several tracks at once.  Each
+/// track belongs to one thread only, and tracks share no clips, so the
+/// caches need no locking; the threads just take the next track from a
+/// shared counter.  Spectrograms are not prefetched: the clips hand their
+/// columns to WaveClip's spectrum workers, which don't hold up the draw.
+///
+/// Tracks may share block files, so one block can be read on two workers
+/// at once, as playback already reads blocks beside the drawing thread.
+/// That is safe: a block's data and summary never change once written,
+/// each read opens the disk file for itself, and OD blocks lock their own
+/// reads.  The only thing a read changes is whether a missing file is
+/// still logged; see BlockFileSilencer.  The drawing thread waits for the
+/// workers, so meanwhile no track is edited and no block's memory cache
+/// is filled or written out.
+class TrackPrefetchWorker : public wxThread
+{
+ public:
+   TrackPrefetchWorker(TrackPrefetch *items, int count, int *next,
+                       wxCriticalSection *nextLock, const ViewInfo *viewInfo)
+      : wxThread(wxTHREAD_JOINABLE)
+   {
+      mItems = items;
+      mCount = count;
+      mNext = next;
+      mNextLock = nextLock;
+      mViewInfo = viewInfo;
+   }
+
+   virtual void *Entry()
+   {
+      Work();
+      return NULL;
+   }
+
+   /// Prefetches tracks until there are none left.  Also called on the
+   /// drawing thread for a worker whose thread couldn't be created.
+   void Work()
+   {
+      for (;;) {
+         int i;
+         {
+            wxCriticalSectionLocker locker(*mNextLock);
+            i = (*mNext)++;
+         }
+         if (i >= mCount)
+            break;
+         Prefetch(mItems[i]);
+      }
+   }
+
+   void Prefetch(const TrackPrefetch &item)
+   {
+      WaveClipList::compatibility_iterator it;
+      for (it = item.track->GetClipIterator(); it; it = it->GetNext()) {
+         WaveClip *clip = it->GetData();
+         ClipParameters params(clip, item.r, mViewInfo);
+         double t0 = params.t0;
+         int width = params.mid.width;
+         if (width <= 0)
+            continue;
+
+         sampleCount *where = new sampleCount[width + 1];
+         float *min = new float[width];
+         float *max = new float[width];
+         float *rms = new float[width];
+         int *bl = new int[width];
+         bool isLoadingOD = false;
+         clip->GetWaveDisplay(min, max, rms, bl, where,
+                              width, t0, mViewInfo->zoom, isLoadingOD);
+         delete[] min;
+         delete[] max;
+         delete[] rms;
+         delete[] bl;
+         delete[] where;
+      }
+   }
+
+ private:
+   TrackPrefetch *mItems;
+   int mCount;
+   int *mNext;
+   wxCriticalSection *mNextLock;
+   const ViewInfo *mViewInfo;
+};
+
 TrackArtist::TrackArtist()
 {
    mInsetLeft   = 0;
@@ -230,6 +536,7 @@ TrackArtist::TrackArtist()
 
    mdBrange = ENV_DB_RANGE;
    mShowClipping = false;
+   mWaitForSpectrum = false;
    UpdatePrefs();
 
    SetColours();
@@ -321,7 +628,7 @@ void TrackArtist::DrawTracks(TrackList * tracks,
    dc.DrawRectangle(clip);
 #endif
 
-   gPrefs->Read(wxT("/GUI/ShowTrackNameInWaveform"), &mbShowTrackNameInWaveform, false);
+   PrefetchTracks(tracks, start, reg, r, clip, viewInfo);
 
    t = iter.StartWith(start);
    while (t) {
@@ -404,6 +711,109 @@ void TrackArtist::DrawTracks(TrackList * tracks,
    }
 }
 
+/// Reading summaries and computing spectra is most of the work of drawing
+/// wave tracks and doesn't touch the wxDC, so it is done here for all the
+/// visible wave tracks on several threads.  DrawTracks() then finds what it
+/// needs in the clips' caches.
+void TrackArtist::PrefetchTracks(TrackList *tracks, Track *start,
+                                 wxRegion &reg,
+                                 const wxRect &r, const wxRect &clip,
+                                 const ViewInfo *viewInfo)
+{
+   int numCPUs = wxThread::GetCPUCount();
+   if (numCPUs <= 1)
+      return;
+
+   TrackListIterator iter(tracks);
+   int count = 0;
+   int allocated = 0;
+   TrackPrefetch *items = NULL;
+
+   for (Track *t = iter.StartWith(start); t; t = iter.Next()) {
+      int y = t->GetY() - viewInfo->vpos;
+      if (y > clip.GetBottom() && !t->GetLinked())
+         break;
+      // Keep stereo pairs together, as DrawTracks() does
+      int top = y, bottom = y + t->GetHeight();
+      Track *link = t->GetLink();
+      if (link) {
+         if (t->GetLinked())
+            bottom += link->GetHeight();
+         else
+            top -= link->GetHeight();
+      }
+      // Only what DrawTracks() will draw
+      wxRect stereoTrackRect(r.x, top, r.width, bottom - top);
+      if (!stereoTrackRect.Intersects(clip) || !reg.Contains(stereoTrackRect))
+         continue;
+      if (t->GetKind() != Track::Wave)
+         continue;
+
+      WaveTrack *wt = (WaveTrack *)t;
+      switch (wt->GetDisplay()) {
+      case WaveTrack::SpectrumDisplay:
+      case WaveTrack::SpectrumLogDisplay:
+      case WaveTrack::PitchDisplay:
+         // Only the waveform, which DrawSpectrum() shows instead during
+         // playback.  Autocorrelation uses FFT(), whose tables are set up
+         // lazily and not safe to share between threads.
+         if (viewInfo->bUpdateTrackIndicator || !viewInfo->bIsPlaying)
+            continue;
+         break;
+      default:
+         break;
+      }
+
+      if (count == allocated) {
+         allocated = allocated ? 2 * allocated : 16;
+         TrackPrefetch *grown = new TrackPrefetch[allocated];
+         for (int i = 0; i < count; i++)
+            grown[i] = items[i];
+         delete[] items;
+         items = grown;
+      }
+      items[count].track = wt;
+      items[count].r = r;
+      items[count].r.x += mInsetLeft;
+      items[count].r.width -= (mInsetLeft + mInsetRight);
+      count++;
+   }
+
+   // One track is left to DrawTrack(); there is nothing to overlap it with
+   int numThreads = wxMin(numCPUs, count);
+   if (numThreads > 1) {
+      int next = 0;
+      wxCriticalSection nextLock;
+      TrackPrefetchWorker **workers = new TrackPrefetchWorker*[numThreads];
+      int i;
+      for (i = 0; i < numThreads; i++) {
+         workers[i] = new TrackPrefetchWorker(items, count, &next, &nextLock,
+                                              viewInfo);
+         if (workers[i]->Create() != wxTHREAD_NO_ERROR ||
+             workers[i]->Run() != wxTHREAD_NO_ERROR) {
+            // Do its share here instead
+            delete workers[i];
+            workers[i] = NULL;
+         }
+      }
+      for (i = 0; i < numThreads; i++)
+         if (!workers[i]) {
+            TrackPrefetchWorker here(items, count, &next, &nextLock, viewInfo);
+            here.Work();
+            break;
+         }
+      for (i = 0; i < numThreads; i++) {
+         if (workers[i]) {
+            workers[i]->Wait();
+            delete workers[i];
+         }
+      }
+      delete[] workers;
+   }
+
+   delete[] items;
+}
+
 void TrackArtist::DrawTrack(const Track * t,
                             wxDC & dc,
                             const wxRect & r,
@@ -938,7 +1348,8 @@ void TrackArtist::DrawNegativeOffsetTrackArrows(wxDC &dc, const wxRect &r)
                 r.x + 6, r.y + r.height - 12);
 }
 
-void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double env[],
+void TrackArtist::DrawWaveformBackground(wxDC &dc, WaveformPainter &painter,
+                                         const wxRect &r, const double env[],
                                          float zoomMin, float zoomMax, bool dB,
                                          const sampleCount where[],
                                          sampleCount ssel0, sampleCount ssel1,
@@ -963,9 +1374,7 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
    int x, lx = 0;
    int l, w;
 
-   dc.SetPen(*wxTRANSPARENT_PEN);
-   dc.SetBrush(blankBrush);
-   dc.DrawRectangle(r);
+   painter.Rectangle(blankBrush.GetColour(), r.x, r.y, r.width, r.height);
 
    for (x = 0; x < r.width; x++) {
       // First we compute the truncated shape of the waveform background.
@@ -1002,16 +1411,17 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
          continue;
       }
 
-      dc.SetBrush(lsel ? selectedBrush : unselectedBrush);
+      const wxColour &colour =
+         (lsel ? selectedBrush : unselectedBrush).GetColour();
 
       l = r.x + lx;
       w = x - lx;
       if (lmaxbot < lmintop - 1) {
-         dc.DrawRectangle(l, r.y + lmaxtop, w, lmaxbot - lmaxtop);
-         dc.DrawRectangle(l, r.y + lmintop, w, lminbot - lmintop);
+         painter.Rectangle(colour, l, r.y + lmaxtop, w, lmaxbot - lmaxtop);
+         painter.Rectangle(colour, l, r.y + lmintop, w, lminbot - lmintop);
       }
       else {
-         dc.DrawRectangle(l, r.y + lmaxtop, w, lminbot - lmaxtop);
+         painter.Rectangle(colour, l, r.y + lmaxtop, w, lminbot - lmaxtop);
       }
 
       lmaxtop = maxtop;
@@ -1022,18 +1432,20 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
       lx = x;
    }
 
-   dc.SetBrush(lsel ? selectedBrush : unselectedBrush);
+   const wxColour &colour =
+      (lsel ? selectedBrush : unselectedBrush).GetColour();
    l = r.x + lx;
    w = x - lx;
    if (lmaxbot < lmintop - 1) {
-      dc.DrawRectangle(l, r.y + lmaxtop, w, lmaxbot - lmaxtop);
-      dc.DrawRectangle(l, r.y + lmintop, w, lminbot - lmintop);
+      painter.Rectangle(colour, l, r.y + lmaxtop, w, lmaxbot - lmaxtop);
+      painter.Rectangle(colour, l, r.y + lmintop, w, lminbot - lmintop);
    }
    else {
-      dc.DrawRectangle(l, r.y + lmaxtop, w, lminbot - lmaxtop);
+      painter.Rectangle(colour, l, r.y + lmaxtop, w, lminbot - lmaxtop);
    }
 
    // If sync-lock selected, draw in linked graphics.
+   // (The caller paints straight onto dc in that case.)
    if (bIsSyncLockSelected && ssel0 < ssel1) {
       // Find the beginning/end of the selection
       int begin, end;
@@ -1049,19 +1461,18 @@ void TrackArtist::DrawWaveformBackground(wxDC &dc, const wxRect &r, const double
 
    if (zoomMin < 0 && zoomMax > 0) {
       int half = (int)((zoomMax / (zoomMax - zoomMin)) * h);
-      dc.SetPen(*wxBLACK_PEN);
-      AColor::Line(dc, r.x, r.y + half, r.x + r.width, r.y + half);
+      painter.Line(*wxBLACK, r.x, r.y + half, r.x + r.width, r.y + half);
    }
 }
 
 
 #ifdef EXPERIMENTAL_OUTPUT_DISPLAY
-void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
+void TrackArtist::DrawMinMaxRMS(WaveformPainter &painter, const wxRect &r, const double env[],
                                 float zoomMin, float zoomMax, bool dB,
                                 const float min[], const float max[], const float rms[],
                                 const int bl[], bool showProgress, bool muted, const float gain)
 #else
-void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
+void TrackArtist::DrawMinMaxRMS(WaveformPainter &painter, const wxRect &r, const double env[],
                                 float zoomMin, float zoomMax, bool dB,
                                 const float min[], const float max[], const float rms[],
                                 const int bl[], bool WXUNUSED(showProgress), bool muted)
@@ -1089,7 +1500,7 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
    bool drawStripes = true;
    bool drawWaveform = true;
 
-   dc.SetPen(muted ? muteSamplePen : samplePen);
+   const wxColour &sampleColour = (muted ? muteSamplePen : samplePen).GetColour();
    for (x = 0; x < r.width; x++) {
       int xx = r.x + x;
       double v;
@@ -1160,10 +1571,11 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
       if (bl[x] <= -1) {
          if (drawStripes) {
             // TODO:unify with buffer drawing.
-            dc.SetPen((bl[x] % 2) ? muteSamplePen : samplePen);
+            const wxColour &stripeColour =
+               ((bl[x] % 2) ? muteSamplePen : samplePen).GetColour();
             for (int y = 0; y < r.height / 25 + 1; y++) {
                // we are drawing over the buffer, but I think DrawLine takes care of this.
-               AColor::Line(dc,
+               painter.Line(stripeColour,
                             xx,
                             r.y + 25 * y + (x /*+pixAnimOffset*/) % 25,
                             xx,
@@ -1175,36 +1587,36 @@ void TrackArtist::DrawMinMaxRMS(wxDC &dc, const wxRect &r, const double env[],
          // Lets use a triangle wave for now since it's easier - I don't want to use sin() or make a wavetable just for this.
          if (drawWaveform) {
             int triX;
-            dc.SetPen(samplePen);
             triX = fabs((double)((x + pixAnimOffset) % (2 * r.height)) - r.height) + r.height;
             for (int y = 0; y < r.height; y++) {
                if ((y + triX) % r.height == 0) {
-                  dc.DrawPoint(xx, r.y + y);
+                  painter.Point(samplePen.GetColour(), xx, r.y + y);
                }
             }
          }
       }
       else {
-         AColor::Line(dc, xx, r.y + h2, xx, r.y + h1);
+         painter.Line(sampleColour, xx, r.y + h2, xx, r.y + h1);
       }
    }
 
-   dc.SetPen(muted ? muteRmsPen : rmsPen);
+   const wxColour &rmsColour = (muted ? muteRmsPen : rmsPen).GetColour();
    for (int x = 0; x < r.width; x++) {
       int xx = r.x + x;
       if (bl[x] <= -1) {
       }
       else if (r1[x] != r2[x]) {
-         AColor::Line(dc, xx, r.y + r2[x], xx, r.y + r1[x]);
+         painter.Line(rmsColour, xx, r.y + r2[x], xx, r.y + r1[x]);
       }
    }
 
    // Draw the clipping lines
    if (clipcnt) {
-      dc.SetPen(muted ? muteClippedPen : clippedPen);
+      const wxColour &clippedColour =
+         (muted ? muteClippedPen : clippedPen).GetColour();
       while (--clipcnt >= 0) {
          int xx = clipped[clipcnt];
-         AColor::Line(dc, xx, r.y, xx, r.y + r.height);
+         painter.Line(clippedColour, xx, r.y, xx, r.y + r.height);
       }
    }
 
@@ -1449,46 +1861,25 @@ void TrackArtist::DrawClipWaveform(WaveTrack *track,
    double trackLen = clip->GetEndTime() - clip->GetStartTime();
    double tOffset = clip->GetOffset();
    double rate = clip->GetRate();
-   double sps = 1./rate;            //seconds-per-sample
 
    //If the track isn't selected, make the selection empty
    if (!track->GetSelected() && !track->IsSyncLockSelected()) {
       sel0 = sel1 = 0.0;
    }
 
-   //Some bookkeeping time variables:
-   double tstep = 1.0 / pps;                  // Seconds per point
-   double tpre = h - tOffset;                 // offset corrected time of
-                                              //  left edge of display
-   double tpost = tpre + (r.width * tstep);   // offset corrected time of
-                                              //  right edge of display
+   ClipParameters params(clip, r, viewInfo);
+   double tstep = params.tstep;
+   double tpre = params.tpre;
+   double tpost = params.tpost;
+   double t0 = params.t0;
+   double t1 = params.t1;
+   wxRect mid = params.mid;
 
    // Determine whether we should show individual samples
    // or draw circular points as well
-   bool showIndividualSamples = (pps / rate > 0.5);   //zoomed in a lot
+   bool showIndividualSamples = params.showIndividualSamples;
    bool showPoints = (pps / rate > 3.0);              //zoomed in even more
 
-   // Calculate actual selection bounds so that t0 > 0 and t1 < the
-   // end of the track
-
-   double t0 = (tpre >= 0.0 ? tpre : 0.0);
-   double t1 = (tpost < trackLen - sps * .99 ? tpost : trackLen - sps * .99);
-   if (showIndividualSamples) {
-      // adjustment so that the last circular point doesn't appear
-      // to be hanging off the end
-      t1 += 2. / pps;
-   }
-
-   // Make sure t1 (the right bound) is greater than 0
-   if (t1 < 0.0) {
-      t1 = 0.0;
-   }
-
-   // Make sure t1 is greater than t0
-   if (t0 > t1) {
-      t0 = t1;
-   }
-
    // Calculate sample-based offset-corrected selection
 
    // Use the WaveTrack method to show what is selected and 'should' be copied, pasted etc.
@@ -1500,38 +1891,8 @@ void TrackArtist::DrawClipWaveform(WaveTrack *track,
       ssel1 = (sampleCount)(0.5 + trackLen * rate);
    }
 
-   // The variable "mid" will be the rectangle containing the
-   // actual waveform, as opposed to any blank area before
-   // or after the track.
-   wxRect mid = r;
-
    dc.SetPen(*wxTRANSPARENT_PEN);
 
-   // If the left edge of the track is to the right of the left
-   // edge of the display, then there's some blank area to the
-   // left of the track.  Reduce the "mid"
-   if (tpre < 0) {
-      double delta = r.width;
-      if (t0 < tpost) {
-         delta = (int) ((t0 - tpre) * pps);
-      }
-      mid.x += (int)delta;
-      mid.width -= (int)delta;
-   }
-
-   // If the right edge of the track is to the left of the the right
-   // edge of the display, then there's some blank area to the right
-   // of the track.  Reduce the "mid" rect by the
-   // size of the blank area.
-   if (tpost > t1) {
-      wxRect post = r;
-      if (t1 > tpre) {
-         post.x += (int) ((t1 - tpre) * pps);
-      }
-      post.width = r.width - (post.x - r.x);
-      mid.width -= post.width;
-   }
-
    // The "mid" rect contains the part of the display actually
    // containing the waveform.  If it's empty, we're done.
    if (mid.width <= 0) {
@@ -1591,19 +1952,30 @@ void TrackArtist::DrawClipWaveform(WaveTrack *track,
    double *envValues = new double[mid.width];
    clip->GetEnvelope()->GetValues(envValues, mid.width, t0 + tOffset, tstep);
 
+   // Background and min/max/rms are rendered into an image and blitted
+   // at once, unless sync-lock tiles or individual samples have to be
+   // drawn between them, in which case everything goes onto dc directly
+   bool bIsSyncLockSelected = !track->GetSelected();
+   bool raster = !showIndividualSamples && mid.height > 0 &&
+      !(bIsSyncLockSelected && ssel0 < ssel1);
+   RasterWaveformPainter rasterPainter(raster ? mid : wxRect());
+   DCWaveformPainter dcPainter(dc);
+   WaveformPainter &painter =
+      raster ? (WaveformPainter &)rasterPainter : (WaveformPainter &)dcPainter;
+
    // Draw the background of the track, outlining the shape of
    // the envelope and using a colored pen for the selected
    // part of the waveform
-   DrawWaveformBackground(dc, mid, envValues, zoomMin, zoomMax, dB,
+   DrawWaveformBackground(dc, painter, mid, envValues, zoomMin, zoomMax, dB,
                           where, ssel0, ssel1, drawEnvelope,
-                          !track->GetSelected());
+                          bIsSyncLockSelected);
 
    if (!showIndividualSamples) {
 #ifdef EXPERIMENTAL_OUTPUT_DISPLAY
-      DrawMinMaxRMS(dc, mid, envValues, zoomMin, zoomMax, dB,
+      DrawMinMaxRMS(painter, mid, envValues, zoomMin, zoomMax, dB,
                     min, max, rms, bl, isLoadingOD, muted, track->GetChannelGain(track->GetChannel()));
 #else
-      DrawMinMaxRMS(dc, mid, envValues, zoomMin, zoomMax, dB,
+      DrawMinMaxRMS(painter, mid, envValues, zoomMin, zoomMax, dB,
                     min, max, rms, bl, isLoadingOD, muted);
 #endif
    }
@@ -1613,6 +1985,9 @@ void TrackArtist::DrawClipWaveform(WaveTrack *track,
                             drawSamples, showPoints, muted);
    }
 
+   if (raster)
+      rasterPainter.Blit(dc);
+
    if (drawEnvelope) {
       DrawEnvelope(dc, mid, envValues, zoomMin, zoomMax, dB);
       clip->GetEnvelope()->DrawPoints(dc, r, h, pps, dB, zoomMin, zoomMax);
@@ -1754,24 +2129,47 @@ void TrackArtist::DrawSpectrum(WaveTrack *track,
    }
 }
 
-static float sumFreqValues(float *freq, int x0, float bin0, float bin1)
+/// The FFT bins making up one pixel row of a spectrogram, and how much
+/// each of the partly covered bins at the ends counts.  Rows are the same
+/// in every column, so DrawClipSpectrum() works them out once per draw.
+struct SpectrumRow
+{
+   float bin0, bin1;
+   int first;           // int(bin0)
+   int end;             // int(bin1); bins first+1 .. end-1 count fully
+   int last;            // the partly covered bin at the top
+   float firstWeight, lastWeight;
+   float binWidth;
+};
+
+/// @param lastLimit Bins at or beyond this aren't in the column, so the
+///                  top bin is taken one lower
+static void SetSpectrumRow(SpectrumRow &row, float bin0, float bin1,
+                           int lastLimit)
+{
+   row.bin0 = bin0;
+   row.bin1 = bin1;
+   row.first = int(bin0);
+   row.end = int(bin1);
+   row.firstWeight = 1.f - bin0 + (int)bin0;
+   row.binWidth = bin1 - bin0;
+   if (int(bin1) >= lastLimit)
+      bin1 -= 1.0;
+   row.last = int(bin1);
+   row.lastWeight = bin1 - int(bin1);
+}
+
+/// Averages the FFT bins of one row over the column
+static inline float SumSpectrumRow(const float *column, const SpectrumRow &row)
 {
-   float value;
-   if (int(bin1) == int(bin0)) {
-      value = freq[x0+int(bin0)];
-   } else {
-      float binwidth= bin1 - bin0;
-      value = freq[x0 + int(bin0)] * (1.f - bin0 + (int)bin0);
-
-      bin0 = 1 + int (bin0);
-      while (bin0 < int(bin1)) {
-         value += freq[x0 + int(bin0)];
-         bin0 += 1.0;
-      }
-      value += freq[x0 + int(bin1)] * (bin1 - int(bin1));
-      value /= binwidth;
-   }
-   return value;
+   if (row.end == row.first)
+      return column[row.first];
+
+   float value = column[row.first] * row.firstWeight;
+   for (int bin = row.first + 1; bin < row.end; bin++)
+      value += column[bin];
+   value += column[row.last] * row.lastWeight;
+   return value / row.binWidth;
 }
 
 
@@ -1817,7 +2215,6 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
    gettimeofday(&tv0, NULL);
 #  endif
 #endif
-   double h = viewInfo->h;
    double pps = viewInfo->zoom;
    double sel0 = viewInfo->selectedRegion.t0();
    double sel1 = viewInfo->selectedRegion.t1();
@@ -1833,32 +2230,19 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
 
    double tOffset = clip->GetOffset();
    double rate = clip->GetRate();
-   double sps = 1./rate;
 
-   int range = gPrefs->Read(wxT("/Spectrum/Range"), 80L);
-   int gain = gPrefs->Read(wxT("/Spectrum/Gain"), 20L);
+   int range = SpectrogramSettings::defaults().range;
+   int gain = SpectrogramSettings::defaults().gain;
 
    if (!track->GetSelected())
       sel0 = sel1 = 0.0;
 
-   double tpre = h - tOffset;
-   double tstep = 1.0 / pps;
-   double tpost = tpre + (r.width * tstep);
    double trackLen = clip->GetEndTime() - clip->GetStartTime();
 
-   bool showIndividualSamples = (pps / rate > 0.5);   //zoomed in a lot
-   double t0 = (tpre >= 0.0 ? tpre : 0.0);
-   double t1 = (tpost < trackLen - sps*.99 ? tpost : trackLen - sps*.99);
-   if(showIndividualSamples) t1+=2./pps; // for display consistency
-   // with Waveform display
-
-   // Make sure t1 (the right bound) is greater than 0
-   if (t1 < 0.0)
-      t1 = 0.0;
-
-   // Make sure t1 is greater than t0
-   if (t0 > t1)
-      t0 = t1;
+   ClipParameters params(clip, r, viewInfo);
+   double tstep = params.tstep;
+   double t0 = params.t0;
+   wxRect mid = params.mid;
 
    sampleCount ssel0 = wxMax(0, sampleCount((sel0 - tOffset) * rate + .99));
    sampleCount ssel1 = wxMax(0, sampleCount((sel1 - tOffset) * rate + .99));
@@ -1867,44 +2251,8 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
    if (ssel0 != ssel1 && ssel1 > (sampleCount)(0.5+trackLen*rate))
       ssel1 = (sampleCount)(0.5+trackLen*rate);
 
-   // The variable "mid" will be the rectangle containing the
-   // actual waveform, as opposed to any blank area before
-   // or after the track.
-   wxRect mid = r;
-
    dc.SetPen(*wxTRANSPARENT_PEN);
 
-   // If the left edge of the track is to the right of the left
-   // edge of the display, then there's some blank area to the
-   // left of the track.  Reduce the "mid"
-   // rect by size of the blank area.
-   if (tpre < 0) {
-      // Fill in the area to the left of the track
-      wxRect pre = r;
-      if (t0 < tpost)
-         pre.width = (int) ((t0 - tpre) * pps);
-
-      // Offset the rectangle containing the waveform by the width
-      // of the area we just erased.
-      mid.x += pre.width;
-      mid.width -= pre.width;
-   }
-
-   // If the right edge of the track is to the left of the the right
-   // edge of the display, then there's some blank area to the right
-   // of the track.  Reduce the "mid" rect by the
-   // size of the blank area.
-   if (tpost > t1) {
-      wxRect post = r;
-      if (t1 > tpre)
-         post.x += (int) ((t1 - tpre) * pps);
-      post.width = r.width - (post.x - r.x);
-
-      // Reduce the rectangle containing the waveform by the width
-      // of the area we just erased.
-      mid.width -= post.width;
-   }
-
    // The "mid" rect contains the part of the display actually
    // containing the waveform.  If it's empty, we're done.
    if (mid.width <= 0) {
@@ -1938,7 +2286,7 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
    sampleCount *where = new sampleCount[mid.width+1];
 
    bool updated = clip->GetSpectrogram(freq, where, mid.width,
-                              t0, pps, autocorrelation);
+                              t0, pps, autocorrelation, !mWaitForSpectrum);
    int ifreq = lrint(rate/2);
 
    int maxFreq;
@@ -2042,6 +2390,48 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
    }
 #endif //EXPERIMENTAL_FFT_Y_GRID
 
+   // Bins of each row, and the colour set each row gets inside the time
+   // selection (the second half for the odd dashes of the edge lines)
+   SpectrumRow *rows = new SpectrumRow[mid.height];
+   AColor::ColorGradientChoice *rowSelected =
+      new AColor::ColorGradientChoice[2 * mid.height];
+   if (!logF) {
+      for (int yy = 0; yy < mid.height; yy++) {
+         float bin0 = float (yy) * binPerPx + minSamples;
+         float bin1 = float (yy + 1) * binPerPx + minSamples;
+         // Do not reference past end of freq array.
+         SetSpectrumRow(rows[yy], bin0, bin1, half);
+      }
+   }
+   else {
+      double yy2_base=exp(lmin)/f;
+      float yy2 = yy2_base;
+      double exp_scale_per_height = exp(scale/mid.height);
+      for (int yy = 0; yy < mid.height; yy++) {
+         if (int(yy2)>=half)
+            yy2=half-1;
+         if (yy2<0)
+            yy2=0;
+         float bin0 = float(yy2);
+         yy2_base *= exp_scale_per_height;
+         float yy3 = yy2_base;
+         if (int(yy3)>=half)
+            yy3=half-1;
+         if (yy3<0)
+            yy3=0;
+         float bin1 = float(yy3);
+         SetSpectrumRow(rows[yy], bin0, bin1,
+                        std::numeric_limits<int>::max());
+         yy2 = yy2_base;
+      }
+   }
+   for (int yy = 0; yy < mid.height; yy++) {
+      for (int dash = 0; dash < 2; dash++)
+         rowSelected[dash * mid.height + yy] =
+            ChooseColorSet(rows[yy].bin0, rows[yy].bin1,
+                           selBinLo, selBinCenter, selBinHi, dash);
+   }
+
 #ifdef EXPERIMENTAL_FIND_NOTES
    int maxima[128];
    float maxima0[128], maxima1[128];
@@ -2065,52 +2455,27 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
       sampleCount w0 = w1;
       w1 = (sampleCount) ((t0*rate + (x+1) *rate *tstep) + .5);
 
+      // For spectral selection, determine what colour
+      // set to use.  We use a darker selection if
+      // in both spectral range and time range.
+      // If we are in the time selected range, then we may use a differnt color set.
+      const AColor::ColorGradientChoice *columnSelected = NULL;
+      if (ssel0 <= w0 && w1 < ssel1)
+         columnSelected = &rowSelected[((x / DASH_LENGTH) % 2) * mid.height];
+
       // TODO: The logF and non-logF case are very similar.
       // They should be merged and simplified.
       if (!logF)
       {
          for (int yy = 0; yy < mid.height; yy++) {
-            float bin0 = float (yy) * binPerPx + minSamples;
-            float bin1 = float (yy + 1) * binPerPx + minSamples;
-
-            // For spectral selection, determine what colour
-            // set to use.  We use a darker selection if
-            // in both spectral range and time range.
-
-            AColor::ColorGradientChoice selected =
-               AColor::ColorGradientUnselected;
-            // If we are in the time selected range, then we may use a differnt color set.
-            if (ssel0 <= w0 && w1 < ssel1)
-            {
-               selected = ChooseColorSet( bin0, bin1, selBinLo, selBinCenter, selBinHi, x/DASH_LENGTH );
-            }
-
+            AColor::ColorGradientChoice selected = columnSelected ?
+               columnSelected[yy] : AColor::ColorGradientUnselected;
 
             unsigned char rv, gv, bv;
             float value;
 
             if(!usePxCache) {
-               if (int (bin1) == int (bin0))
-                  value = freq[half * x + int (bin0)];
-               else {
-                  float binwidth= bin1 - bin0;
-                  value = freq[half * x + int (bin0)] * (1.f - bin0 + (int)bin0);
-
-                  bin0 = 1 + int (bin0);
-                  while (bin0 < int (bin1)) {
-                     value += freq[half * x + int (bin0)];
-                     bin0 += 1.0;
-                  }
-
-                  // Do not reference past end of freq array.
-                  if (int(bin1) >= half) {
-                     bin1 -= 1.0;
-                  }
-
-                  value += freq[half * x + int (bin1)] * (bin1 - int (bin1));
-
-                  value /= binwidth;
-               }
+               value = SumSpectrumRow(&freq[half * x], rows[yy]);
 
                if (!autocorrelation) {
                   // Last step converts dB to a 0.0-1.0 range
@@ -2203,30 +2568,9 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
          bool inMaximum = false;
 #endif //EXPERIMENTAL_FIND_NOTES
 
-         double yy2_base=exp(lmin)/f;
-         float yy2 = yy2_base;
-         double exp_scale_per_height = exp(scale/mid.height);
          for (int yy = 0; yy < mid.height; yy++) {
-            if (int(yy2)>=half)
-               yy2=half-1;
-            if (yy2<0)
-               yy2=0;
-            float bin0 = float(yy2);
-            yy2_base *= exp_scale_per_height;
-            float yy3 = yy2_base;
-            if (int(yy3)>=half)
-               yy3=half-1;
-            if (yy3<0)
-               yy3=0;
-            float bin1 = float(yy3);
-
-            AColor::ColorGradientChoice selected =
-               AColor::ColorGradientUnselected;
-            // If we are in the time selected range, then we may use a differnt color set.
-            if (ssel0 <= w0 && w1 < ssel1)
-            {
-               selected = ChooseColorSet( bin0, bin1, selBinLo, selBinCenter, selBinHi, x/DASH_LENGTH );
-            }
+            AColor::ColorGradientChoice selected = columnSelected ?
+               columnSelected[yy] : AColor::ColorGradientUnselected;
 
             if(!usePxCache) {
 
@@ -2240,7 +2584,7 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
                      if (inMaximum) {
                         float i1=maxima1[it];
                         if (yy+1 <= i1) {
-                           value=sumFreqValues(freq, x0, bin0, bin1);
+                           value=SumSpectrumRow(&freq[x0], rows[yy]);
                            if (value < mFindNotesMinA)
                               value = minColor;
                            else
@@ -2258,7 +2602,7 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
                } else
 #endif //EXPERIMENTAL_FIND_NOTES
                {
-                  value=sumFreqValues(freq, x0, bin0, bin1);
+                  value=SumSpectrumRow(&freq[x0], rows[yy]);
                   if (!autocorrelation) {
                      // Last step converts dB to a 0.0-1.0 range
                      value = (value + gain + range) / (double)range;
@@ -2272,7 +2616,6 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
             }
             else
                value = clip->mSpecPxCache->values[x * mid.height + yy];
-            yy2 = yy2_base;
 
             GetColorGradient(value, selected, mIsGrayscale, &rv, &gv, &bv);
 
@@ -2308,6 +2651,8 @@ void TrackArtist::DrawClipSpectrum(WaveTrack *track,
    delete image;
    delete[] where;
    delete[] freq;
+   delete[] rows;
+   delete[] rowSelected;
 #ifdef EXPERIMENTAL_FFT_Y_GRID
    delete[] yGrid;
 #endif //EXPERIMENTAL_FFT_Y_GRID
@@ -2736,11 +3081,38 @@ void TrackArtist::DrawNoteTrack(NoteTrack *track,
    // We want to draw in seconds, so we need to convert to seconds
    seq->convert_to_seconds();
 
-   Alg_iterator iterator(seq, false);
-   iterator.begin();
+   // Only visit the notes in view
+   std::vector<Alg_note_ptr> notes;
+   track->FindNotes(h - track->GetOffset(), h1 - track->GetOffset(), notes);
+
+   // When there are more plain notes to draw than pixel columns, don't
+   // draw them one by one; mark which pitches sound in each column, and
+   // in which channel, then draw each pitch's runs of columns at the end.
+   // Count just the notes the loop below would draw as rectangles.
+   int numPlain = 0;
+   for (size_t i = 0; i < notes.size(); i++) {
+      Alg_note_ptr note = notes[i];
+      if (note->get_type() != 'n' ||
+          !(visibleChannels & (1 << (note->chan & 15))))
+         continue;
+      double x = note->time + track->GetOffset();
+      if (!(x < h1 && x + note->dur > h))
+         continue;
+      if (!(note->loud > 0.0 || 0 == IsShape(note)))
+         continue;
+      int nx = r.x + (int) ((x - h) * pps);
+      int nwidth = (int) ((note->dur * pps) + 0.5);
+      if (nx + nwidth >= r.x && nx < r.x + r.width)
+         numPlain++;
+   }
+   // Rows by the same rounded pitch that PitchToY() places a note by;
+   // each entry is the channel plus one, or 0 for no note
+   std::map<int, std::vector<unsigned char> > density;
+   bool dense = (numPlain > r.width && r.width > 0);
+
    //for every event
-   Alg_event_ptr evt;
-   while (0 != (evt = iterator.next())) {
+   for (size_t noteIndex = 0; noteIndex < notes.size(); noteIndex++) {
+      Alg_event_ptr evt = notes[noteIndex];
       if (evt->get_type() == 'n') { // 'n' means a note
          Alg_note_ptr note = (Alg_note_ptr) evt;
          // if the note's channel is visible
@@ -2765,7 +3137,19 @@ void TrackArtist::DrawNoteTrack(NoteTrack *track,
                      if (nr.x + nr.width > r.x + r.width) // clip on right
                         nr.width = r.x + r.width - nr.x;
 
-                     if (nr.y + nr.height < r.y + marg + 3) {
+                     if (dense) {
+                        std::vector<unsigned char> &row =
+                           density[(int) (note->pitch + 0.5)];
+                        if (row.empty())
+                           row.resize(r.width, 0);
+                        // Channels out of 1 - 16 are all drawn grey
+                        int chan = note->chan + 1;
+                        if (chan < 1 || chan > 16)
+                           chan = 17;
+                        int end = nr.x - r.x + wxMax(nr.width, 1);
+                        for (int col = nr.x - r.x; col < end; col++)
+                           row[col] = chan;
+                     } else if (nr.y + nr.height < r.y + marg + 3) {
                          // too high for window
                          nr.y = r.y;
                          nr.height = marg;
@@ -2970,7 +3354,68 @@ void TrackArtist::DrawNoteTrack(NoteTrack *track,
          }
       }
    }
-   iterator.end();
+
+   // Same placement, clipping and edges as single notes get above, for
+   // each run of columns
+   std::map<int, std::vector<unsigned char> >::iterator rowIt;
+   for (rowIt = density.begin(); rowIt != density.end(); ++rowIt) {
+      const std::vector<unsigned char> &row = rowIt->second;
+      wxRect nr;
+      nr.y = track->PitchToY(rowIt->first);
+      nr.height = track->GetPitchHeight();
+      bool outside = false;
+      if (nr.y + nr.height < r.y + marg + 3) { // too high for window
+         nr.y = r.y;
+         nr.height = marg;
+         outside = true;
+      } else if (nr.y >= r.y + r.height - marg - 1) { // too low for window
+         nr.y = r.y + r.height - marg;
+         nr.height = marg;
+         outside = true;
+      } else {
+         if (nr.y + nr.height > r.y + r.height - marg)
+            nr.height = r.y + r.height - nr.y;
+         if (nr.y < r.y + marg) {
+            int offset = r.y + marg - nr.y;
+            nr.height -= offset;
+            nr.y += offset;
+         }
+      }
+      int col = 0;
+      while (col < r.width) {
+         int chan = row[col];
+         int end = col + 1;
+         while (end < r.width && row[end] == chan)
+            end++;
+         if (chan) {
+            nr.x = r.x + col;
+            nr.width = end - col;
+            if (outside) {
+               dc.SetBrush(*wxBLACK_BRUSH);
+               dc.SetPen(*wxBLACK_PEN);
+               dc.DrawRectangle(nr);
+            } else {
+               if (muted)
+                  AColor::LightMIDIChannel(&dc, chan);
+               else
+                  AColor::MIDIChannel(&dc, chan);
+               dc.DrawRectangle(nr);
+               if (track->GetPitchHeight() > 2) {
+                  AColor::LightMIDIChannel(&dc, chan);
+                  AColor::Line(dc, nr.x, nr.y, nr.x + nr.width-2, nr.y);
+                  AColor::Line(dc, nr.x, nr.y, nr.x, nr.y + nr.height-2);
+                  AColor::DarkMIDIChannel(&dc, chan);
+                  AColor::Line(dc, nr.x+nr.width-1, nr.y,
+                        nr.x+nr.width-1, nr.y+nr.height-1);
+                  AColor::Line(dc, nr.x, nr.y+nr.height-1,
+                        nr.x+nr.width-1, nr.y+nr.height-1);
+               }
+            }
+         }
+         col = end;
+      }
+   }
+
    // draw black line between top/bottom margins and the track
    dc.SetPen(*wxBLACK_PEN);
    AColor::Line(dc, r.x, r.y + marg, r.x + r.width, r.y + marg);
@@ -3012,9 +3457,8 @@ void TrackArtist::DrawTimeTrack(TimeTrack *track,
    double lower = track->GetRangeLower(), upper = track->GetRangeUpper();
    if(track->GetDisplayLog()) {
       // MB: silly way to undo the work of GetWaveYPos while still getting a logarithmic scale
-      double dBRange = gPrefs->Read(wxT("/GUI/EnvdBRange"), ENV_DB_RANGE);
-      lower = 20.0 * log10(std::max(1.0e-7, lower)) / dBRange + 1.0;
-      upper = 20.0 * log10(std::max(1.0e-7, upper)) / dBRange + 1.0;
+      lower = 20.0 * log10(std::max(1.0e-7, lower)) / mdBrange + 1.0;
+      upper = 20.0 * log10(std::max(1.0e-7, upper)) / mdBrange + 1.0;
    }
    track->GetEnvelope()->DrawPoints(dc, envRect, viewInfo->h, viewInfo->zoom,
                track->GetDisplayLog(), lower, upper);
@@ -3024,10 +3468,13 @@ void TrackArtist::UpdatePrefs()
 {
    mdBrange = gPrefs->Read(wxT("/GUI/EnvdBRange"), mdBrange);
    mShowClipping = gPrefs->Read(wxT("/GUI/ShowClipping"), mShowClipping);
+   gPrefs->Read(wxT("/GUI/ShowTrackNameInWaveform"), &mbShowTrackNameInWaveform, false);
 
-   // mMaxFreq should have the same default as in SpectrumPrefs.
-   mMaxFreq = gPrefs->Read(wxT("/Spectrum/MaxFreq"), 8000L);
-   mMinFreq = gPrefs->Read(wxT("/Spectrum/MinFreq"), -1);
+   // The spectrum settings shared with WaveClip, already reread by
+   // SpectrumPrefs::Apply()
+   const SpectrogramSettings &settings = SpectrogramSettings::defaults();
+   mMaxFreq = settings.maxFreq;
+   mMinFreq = settings.minFreq;
    mLogMaxFreq = gPrefs->Read(wxT("/SpectrumLog/MaxFreq"), -1);
    if( mLogMaxFreq < 0 )
       mLogMaxFreq = mMaxFreq;
@@ -3037,7 +3484,7 @@ void TrackArtist::UpdatePrefs()
    if (mLogMinFreq < 1)
       mLogMinFreq = 1;
 
-   mWindowSize = gPrefs->Read(wxT("/Spectrum/FFTSize"), 256);
+   mWindowSize = settings.windowSize;
    mIsGrayscale = (gPrefs->Read(wxT("/Spectrum/Grayscale"), 0L) != 0);
 
 #ifdef EXPERIMENTAL_FFT_Y_GRID
@@ -3052,7 +3499,7 @@ void TrackArtist::UpdatePrefs()
 #endif //EXPERIMENTAL_FIND_NOTES
 
 #ifdef EXPERIMENTAL_FFT_SKIP_POINTS
-   mFftSkipPoints = gPrefs->Read(wxT("/Spectrum/FFTSkipPoints"), 0L);
+   mFftSkipPoints = settings.fftSkipPoints;
 #endif //EXPERIMENTAL_FFT_SKIP_POINTS
 
    gPrefs->Flush();
@@ -35,6 +35,7 @@ class LabelTrack;
 class TimeTrack;
 class TrackList;
 class Ruler;
+class WaveformPainter;
 struct ViewInfo;
 
 #ifndef uchar
@@ -91,6 +92,10 @@ class AUDACITY_DLL_API TrackArtist {
      this->selectedPen = selectedPen;
    }
 
+   // Draw spectrograms whole, rather than blank where the columns are still
+   // being worked out in the background; for printing
+   void SetWaitForSpectrum(bool wait) { mWaitForSpectrum = wait; }
+
    // Helper: draws the "sync-locked" watermark tiled to a rectangle
    static void DrawSyncLockTiles(wxDC *dc, wxRect r);
 
@@ -101,6 +106,11 @@ class AUDACITY_DLL_API TrackArtist {
 
  private:
 
+   void PrefetchTracks(TrackList *tracks, Track *start,
+                       wxRegion &reg,
+                       const wxRect &r, const wxRect &clip,
+                       const ViewInfo *viewInfo);
+
    //
    // Lower-level drawing functions
    //
@@ -147,18 +157,19 @@ class AUDACITY_DLL_API TrackArtist {
 
    // Waveform utility functions
 
-   void DrawWaveformBackground(wxDC & dc, const wxRect &r, const double env[],
+   void DrawWaveformBackground(wxDC & dc, WaveformPainter & painter,
+                               const wxRect &r, const double env[],
                                float zoomMin, float zoomMax, bool dB,
                                const sampleCount where[],
                                sampleCount ssel0, sampleCount ssel1,
                                bool drawEnvelope, bool bIsSyncLockSelected);
 #ifdef EXPERIMENTAL_OUTPUT_DISPLAY
-   void DrawMinMaxRMS(wxDC & dc, const wxRect & r, const double env[],
+   void DrawMinMaxRMS(WaveformPainter & painter, const wxRect & r, const double env[],
                       float zoomMin, float zoomMax, bool dB,
                       const float min[], const float max[], const float rms[],
                       const int bl[], bool showProgress, bool muted, const float gain);
 #else
-   void DrawMinMaxRMS(wxDC & dc, const wxRect & r, const double env[],
+   void DrawMinMaxRMS(WaveformPainter & painter, const wxRect & r, const double env[],
                       float zoomMin, float zoomMax, bool dB,
                       const float min[], const float max[], const float rms[],
                       const int bl[], bool showProgress, bool muted);
@@ -185,6 +196,7 @@ class AUDACITY_DLL_API TrackArtist {
    int mWindowSize;           // "/Spectrum/FFTSize"
    bool mIsGrayscale;         // "/Spectrum/Grayscale"
    bool mbShowTrackNameInWaveform;  // "/GUI/ShowTrackNameInWaveform"
+   bool mWaitForSpectrum;
 
 #ifdef EXPERIMENTAL_FFT_SKIP_POINTS
    int mFftSkipPoints;        // "/Spectrum/FFTSkipPoints"
@@ -202,6 +202,7 @@ is time to refresh some aspect of the screen.
 
 #include "NoteTrack.h"
 #include "Prefs.h"
+#include "prefs/SpectrumPrefs.h"
 #include "Project.h"
 #include "Snap.h"
 #include "Theme.h"
@@ -462,6 +463,7 @@ TrackPanel::TrackPanel(wxWindow * parent, wxWindowID id,
      mTrackArtist(NULL),
      mBacking(NULL),
      mRefreshBacking(false),
+     mDrawnSelectionValid(false),
      mConverter(NumericConverter::TIME),
      mAutoScrolling(false),
      mVertScrollRemainder(0),
@@ -561,6 +563,8 @@ TrackPanel::TrackPanel(wxWindow * parent, wxWindowID id,
    mSnapManager = NULL;
    mSnapLeft = -1;
    mSnapRight = -1;
+   mDrawnSnapLeft = -1;
+   mDrawnSnapRight = -1;
 
    mLastCursor = -1;
    mLastIndicator = -1;
@@ -1408,12 +1412,30 @@ void TrackPanel::OnPaint(wxPaintEvent & /* event */)
 
       // Redraw the backing bitmap
       DrawTracks( &mBackingDC );
+      mDirtyBacking.Clear();
+      RememberDrawnSelection();
 
       // Copy it to the display
       dc->Blit( 0, 0, mBacking->GetWidth(), mBacking->GetHeight(), &mBackingDC, 0, 0 );
    }
    else
    {
+      // Bring the out of date parts of the backing bitmap up to date
+      // (See TrackPanel::RefreshSelectionChange())
+      if( !mDirtyBacking.IsEmpty() )
+      {
+         // Clip to the strips themselves, not the box around them, which
+         // would take in everything between the two ends of the selection
+#if wxCHECK_VERSION(3, 0, 0)
+         mBackingDC.SetDeviceClippingRegion( mDirtyBacking );
+#else
+         mBackingDC.SetClippingRegion( mDirtyBacking );
+#endif
+         DrawTracks( &mBackingDC );
+         mBackingDC.DestroyClippingRegion();
+         mDirtyBacking.Clear();
+      }
+
       // Copy full, possibly clipped, damage rectange
       dc->Blit( box.x, box.y, box.width, box.height, &mBackingDC, box.x, box.y );
    }
@@ -2598,9 +2620,10 @@ void TrackPanel::ExtendSelection(int mouseXCoordinate, int trackLeftEdge,
 
 void TrackPanel::UpdateSelectionDisplay()
 {
-   // Full refresh since the label area may need to indicate
+   // Full refresh if the label area may need to indicate
    // newly selected tracks.
-   Refresh(false);
+   if (!RefreshSelectionChange())
+      Refresh(false);
 
    // Make sure the ruler follows suit.
    mRuler->DrawSelection();
@@ -2609,6 +2632,129 @@ void TrackPanel::UpdateSelectionDisplay()
    DisplaySelection();
 }
 
+/// Refreshes only what a change of the time or frequency selection since
+/// the backing bitmap was last brought up to date has affected: the
+/// columns between the old and new positions of each edge, in the tracks
+/// showing the selection, and the snap guidelines.  Returns false, having
+/// done nothing, if that isn't enough because tracks were selected or
+/// deselected.
+bool TrackPanel::RefreshSelectionChange()
+{
+   // A full redraw is already on its way, or nothing has been drawn yet
+   if (!mDrawnSelectionValid || mRefreshBacking)
+      return false;
+
+   wxArrayPtrVoid tracks;
+   GetSelectionShowingTracks(tracks);
+   if (tracks.GetCount() != mDrawnSelectedTracks.GetCount())
+      return false;
+   size_t i;
+   for (i = 0; i < tracks.GetCount(); i++) {
+      if (tracks[i] != mDrawnSelectedTracks[i])
+         return false;
+   }
+
+   int width, height;
+   GetSize(&width, &height);
+   int left = GetLeftOffset();
+
+   // The columns that changed, widened a little for rounding
+   const SelectedRegion &sel = mViewInfo->selectedRegion;
+   wxInt64 edges[4] = {
+      TimeToPosition(mDrawnSelection.t0(), left),
+      TimeToPosition(sel.t0(), left),
+      TimeToPosition(mDrawnSelection.t1(), left),
+      TimeToPosition(sel.t1(), left),
+   };
+   int strips[4];
+   int numStrips = 0;
+   for (int e = 0; e < 4; e += 2) {
+      if (edges[e] == edges[e + 1])
+         continue;
+      wxInt64 x0 = wxMin(edges[e], edges[e + 1]) - 2;
+      wxInt64 x1 = wxMax(edges[e], edges[e + 1]) + 3;
+      if (x0 < left)
+         x0 = left;
+      if (x1 > width)
+         x1 = width;
+      if (x0 < x1) {
+         strips[numStrips++] = (int)x0;
+         strips[numStrips++] = (int)x1;
+      }
+   }
+   bool freqChanged = sel.f0() != mDrawnSelection.f0() ||
+      sel.f1() != mDrawnSelection.f1();
+
+   wxRegion damage;
+   for (i = 0; i < tracks.GetCount(); i++) {
+      Track *t = (Track *)tracks[i];
+      int y = t->GetY() - mViewInfo->vpos;
+      int h = t->GetHeight();
+#ifdef EXPERIMENTAL_OUTPUT_DISPLAY
+      if (MONO_WAVE_PAN(t))
+         h += t->GetHeight(true);
+#endif
+      if (y + h <= 0 || y >= height)
+         continue;
+
+      // Wave tracks show the selection column by column; others (labels,
+      // notes) may highlight whole items that merely overlap it
+      if (freqChanged || t->GetKind() != Track::Wave) {
+         if (numStrips > 0 || freqChanged)
+            damage.Union(wxRect(left, y, width - left, h));
+         continue;
+      }
+      for (int s = 0; s < numStrips; s += 2)
+         damage.Union(wxRect(strips[s], y, strips[s + 1] - strips[s], h));
+   }
+
+   // The snap guidelines run through every track
+   if (mSnapLeft != mDrawnSnapLeft || mSnapRight != mDrawnSnapRight) {
+      wxInt64 snaps[4] = { mDrawnSnapLeft, mSnapLeft,
+                           mDrawnSnapRight, mSnapRight };
+      for (int s = 0; s < 4; s++) {
+         if (snaps[s] >= 0 && snaps[s] < width)
+            damage.Union(wxRect((int)snaps[s] - 1, 0, 3, height));
+      }
+   }
+
+   RememberDrawnSelection();
+
+   if (damage.IsEmpty())
+      return true;
+
+   mDirtyBacking.Union(damage);
+   for (wxRegionIterator it(damage); it; ++it) {
+      wxRect r = it.GetRect();
+      wxWindow::Refresh(false, &r);
+   }
+
+   return true;
+}
+
+/// The tracks whose drawing depends on the selected time range, in order.
+void TrackPanel::GetSelectionShowingTracks(wxArrayPtrVoid &tracks)
+{
+   TrackListIterator iter(mTracks);
+   for (Track *t = iter.First(); t; t = iter.Next()) {
+      if (t->GetSelected() || t->IsSyncLockSelected())
+         tracks.Add(t);
+   }
+}
+
+/// Records the selection the backing bitmap shows once pending refreshes
+/// are painted.  Called by OnPaint() after redrawing the whole bitmap, and
+/// by RefreshSelectionChange() for the strips it has invalidated.
+void TrackPanel::RememberDrawnSelection()
+{
+   mDrawnSelection = mViewInfo->selectedRegion;
+   mDrawnSelectedTracks.Clear();
+   GetSelectionShowingTracks(mDrawnSelectedTracks);
+   mDrawnSnapLeft = mSnapLeft;
+   mDrawnSnapRight = mSnapRight;
+   mDrawnSelectionValid = true;
+}
+
 #ifdef EXPERIMENTAL_SPECTRAL_EDITING
 namespace {
    
@@ -2691,8 +2837,7 @@ void TrackPanel::StartSnappingFreqSelection (WaveTrack *pTrack)
    int windowSize = mTrackArtist->GetSpectrumWindowSize();
    while(windowSize > effectiveLength)
       windowSize >>= 1;
-   int windowType;
-   gPrefs->Read(wxT("/Spectrum/WindowType"), &windowType, 3);
+   int windowType = SpectrogramSettings::defaults().windowType;
    mFrequencySnapper->Calculate(
       SpectrumAnalyst::Spectrum, windowType, windowSize, rate,
       &frequencySnappingData[0], length);
@@ -6826,6 +6971,9 @@ void TrackPanel::Refresh(bool eraseBackground /* = TRUE */,
 void TrackPanel::DrawTracks(wxDC * dc)
 {
    wxRegion region = GetUpdateRegion();
+   // Parts of the backing bitmap may be out of date that aren't on screen
+   if (!mDirtyBacking.IsEmpty())
+      region.Union(mDirtyBacking);
 
    wxRect clip = GetRect();
 
@@ -20,6 +20,7 @@
 #include <wx/window.h>
 
 #include "Experimental.h"
+#include "SelectedRegion.h"
 #include "Sequence.h"  //Stm: included for the sampleCount declaration
 #include "WaveClip.h"
 #include "WaveTrack.h"
@@ -320,6 +321,9 @@ class AUDACITY_DLL_API TrackPanel:public wxPanel {
    virtual void ExtendSelection(int mouseXCoordinate, int trackLeftEdge,
                         Track *pTrack);
    virtual void UpdateSelectionDisplay();
+   bool RefreshSelectionChange();
+   void GetSelectionShowingTracks(wxArrayPtrVoid &tracks);
+   void RememberDrawnSelection();
 
    // Handle small cursor and play head movements
    void SeekLeftOrRight
@@ -567,6 +571,17 @@ protected:
    wxMemoryDC mBackingDC;
    wxBitmap *mBacking;
    bool mRefreshBacking;
+
+   // Parts of the backing bitmap that are out of date but haven't been
+   // covered by a full refresh.  Together with the selection they were
+   // drawn with, this lets a selection drag redraw just the columns
+   // around the moving edges.
+   wxRegion mDirtyBacking;
+   bool mDrawnSelectionValid;
+   SelectedRegion mDrawnSelection;
+   wxArrayPtrVoid mDrawnSelectedTracks;
+   wxInt64 mDrawnSnapLeft;
+   wxInt64 mDrawnSnapRight;
    int mPrevWidth;
    int mPrevHeight;
 
@@ -26,15 +26,23 @@ drawing).  Cache's the Spectrogram frequency samples.
 *//*******************************************************************/
 
 #include <math.h>
+#include <float.h>
+#include <deque>
+#include <list>
+#include <map>
+#include <set>
 #include <vector>
 #include <wx/log.h>
+#include <wx/thread.h>
 
 #include "Spectrum.h"
 #include "Prefs.h"
 #include "WaveClip.h"
+#include "BlockFile.h"
 #include "Envelope.h"
 #include "Resample.h"
 #include "Project.h"
+#include "prefs/SpectrumPrefs.h"
 
 #include <wx/listimpl.cpp>
 WX_DEFINE_LIST(WaveClipList);
@@ -213,6 +221,148 @@ protected:
 
 };
 
+// Waveform columns at power-of-two widths, kept across zoom changes.
+// A column of level k covers samples [c << k, (c+1) << k).  Any zoom of at
+// least 256 samples per pixel is drawn by merging the columns of a level
+// that puts a few of them in each pixel, so zooming gestures and scrolling
+// reuse what has been read before instead of going back to the block files.
+// Columns are fetched in chunks, and chunks holding on-demand blocks that
+// are not ready yet are never kept.
+#define WAVE_ZOOM_CHUNK 1024        // columns per chunk
+#define WAVE_ZOOM_MAX_CHUNKS 128    // about 2MB per clip
+
+class WaveZoomCache {
+public:
+   struct Chunk {
+      int          len;             // columns filled, fewer at the clip end
+      float        min[WAVE_ZOOM_CHUNK];
+      float        max[WAVE_ZOOM_CHUNK];
+      float        rms[WAVE_ZOOM_CHUNK];
+      int          bl[WAVE_ZOOM_CHUNK];
+   };
+
+   WaveZoomCache()
+   {
+      dirty = -1;
+      mScratch = new Chunk;
+   }
+
+   ~WaveZoomCache()
+   {
+      Clear();
+      delete mScratch;
+   }
+
+   // Fills pixels [p0, p1) of cache from level 'level', reading chunks
+   // from sequence as needed.  Returns false if the sequence could not
+   // supply them.
+   bool Fill(Sequence *sequence, WaveCache *cache, int p0, int p1, int level)
+   {
+      sampleCount numSamples = sequence->GetNumSamples();
+      sampleCount half = ((sampleCount)1 << level) >> 1;
+      const Chunk *chunk = NULL;
+      sampleCount chunkIndex = -1;
+
+      for (int x = p0; x < p1; x++) {
+         sampleCount c0 = (cache->where[x] + half) >> level;
+         sampleCount c1 = (cache->where[x + 1] + half) >> level;
+         if ((c0 << level) >= numSamples)
+            c0 = (numSamples - 1) >> level;
+         if (c1 <= c0)
+            c1 = c0 + 1;
+
+         float theMin = FLT_MAX, theMax = -FLT_MAX, sumsq = 0;
+         int count = 0;
+         for (sampleCount c = c0; c < c1; c++) {
+            if (c / WAVE_ZOOM_CHUNK != chunkIndex) {
+               chunkIndex = c / WAVE_ZOOM_CHUNK;
+               chunk = GetChunk(sequence, level, chunkIndex);
+               if (!chunk)
+                  return false;
+            }
+            int i = (int)(c % WAVE_ZOOM_CHUNK);
+            if (i >= chunk->len)
+               break;
+            if (count == 0)
+               cache->bl[x] = chunk->bl[i];
+            if (chunk->min[i] < theMin)
+               theMin = chunk->min[i];
+            if (chunk->max[i] > theMax)
+               theMax = chunk->max[i];
+            sumsq += chunk->rms[i] * chunk->rms[i];
+            count++;
+         }
+         if (count == 0)
+            return false;
+
+         cache->min[x] = theMin;
+         cache->max[x] = theMax;
+         cache->rms[x] = (float)sqrt(sumsq / count);
+      }
+      return true;
+   }
+
+   void Clear()
+   {
+      std::map<std::pair<int, sampleCount>, Chunk *>::iterator it;
+      for (it = mChunks.begin(); it != mChunks.end(); ++it)
+         delete it->second;
+      mChunks.clear();
+      mOrder.clear();
+   }
+
+   int          dirty;
+
+private:
+   const Chunk *GetChunk(Sequence *sequence, int level, sampleCount index)
+   {
+      std::pair<int, sampleCount> key(level, index);
+      std::map<std::pair<int, sampleCount>, Chunk *>::iterator it = mChunks.find(key);
+      if (it != mChunks.end())
+         return it->second;
+
+      sampleCount numSamples = sequence->GetNumSamples();
+      sampleCount first = index * WAVE_ZOOM_CHUNK;
+      if ((first << level) >= numSamples)
+         return NULL;
+      int len = (int)wxMin((sampleCount)WAVE_ZOOM_CHUNK,
+                           (numSamples - (first << level) +
+                            ((sampleCount)1 << level) - 1) >> level);
+
+      sampleCount where[WAVE_ZOOM_CHUNK + 1];
+      for (int i = 0; i <= len; i++)
+         where[i] = wxMin((first + i) << level, numSamples);
+
+      Chunk *chunk = mScratch;
+      chunk->len = len;
+      if (!sequence->GetWaveDisplay(chunk->min, chunk->max, chunk->rms,
+                                    chunk->bl, len, where,
+                                    (double)((sampleCount)1 << level)))
+         return NULL;
+
+      for (int i = 0; i < len; i++)
+         if (chunk->bl[i] < 0)
+            return chunk;   // still loading, so use it this once only
+
+      // Keep it, forgetting the oldest chunk if there are too many
+      if (mOrder.size() >= WAVE_ZOOM_MAX_CHUNKS) {
+         it = mChunks.find(mOrder.front());
+         mScratch = it->second;
+         mChunks.erase(it);
+         mOrder.pop_front();
+      }
+      else
+         mScratch = new Chunk;
+      mChunks[key] = chunk;
+      mOrder.push_back(key);
+      return chunk;
+   }
+
+   std::map<std::pair<int, sampleCount>, Chunk *> mChunks;
+   std::deque<std::pair<int, sampleCount> > mOrder;   // oldest first
+   Chunk       *mScratch;
+};
+
 class SpecCache {
 public:
    SpecCache(int cacheLen, int half, bool autocorrelation)
@@ -234,12 +384,17 @@ public:
       ac = autocorrelation;
       freq = new float[len*half];
       where = new sampleCount[len+1];
+      pending = new bool[len];
+      for (int x = 0; x < len; x++)
+         pending[x] = false;
+      numPending = 0;
    }
 
    ~SpecCache()
    {
       delete[] freq;
       delete[] where;
+      delete[] pending;
    }
 
    int          minFreqOld;
@@ -259,8 +414,118 @@ public:
    double       pps;
    sampleCount *where;
    float       *freq;
+   bool        *pending;     // blank, left to the spectrum workers
+   int          numPending;
 };
 
+// Spectrogram columns (already in dB, gain factor applied), remembered by
+// what they were computed from.  SpecCache only holds the columns for one
+// zoom and scroll position; this lets a view seen before pick its columns
+// up again instead of recomputing them.
+//
+// A column's key is the FFT settings and rate, then the zeros padding the
+// window before the start of the clip, then Sequence::GetContentKey() for
+// the samples read.  That names the block files the window covers rather
+// than where it is in the clip, so editing one part of a clip keeps the
+// columns of the rest, even where the edit moved them.
+//
+// One budget covers the columns of all clips together; the least recently
+// used are dropped first.  Clips may be drawn on different threads, so the
+// cache is guarded by a lock.
+#define SPEC_COLUMN_CACHE_FLOATS (1 << 23)   // 32MB in all
+
+typedef std::vector<sampleCount> SpecColumnKey;
+
+struct SpecColumn {
+   SpecColumnKey key;
+   float       *data;
+   int          half;
+};
+
+typedef std::list<SpecColumn> SpecColumnList;
+
+static SpecColumnList sSpecColumns;   // least recently used first
+static std::map<SpecColumnKey, SpecColumnList::iterator> sSpecColumnIndex;
+static size_t sSpecColumnFloats = 0;
+static ODLock sSpecColumnMutex;
+
+// Copies the column with this key into column, if there is one
+static bool FindSpecColumn(const SpecColumnKey &key, float *column)
+{
+   sSpecColumnMutex.Lock();
+   std::map<SpecColumnKey, SpecColumnList::iterator>::iterator it =
+      sSpecColumnIndex.find(key);
+   if (it == sSpecColumnIndex.end()) {
+      sSpecColumnMutex.Unlock();
+      return false;
+   }
+
+   // Now the most recently used
+   sSpecColumns.splice(sSpecColumns.end(), sSpecColumns, it->second);
+   memcpy(column, it->second->data, it->second->half * sizeof(float));
+   sSpecColumnMutex.Unlock();
+   return true;
+}
+
+// Fills key for the column centred on centre, reading at most bufferLen
+// samples for a window of windowSize, or leaves it empty if the column
+// can't be cached
+static void MakeSpecColumnKey(const Sequence *sequence,
+                              const SpecColumnKey &settingsKey,
+                              sampleCount centre, int windowSize,
+                              int bufferLen, SpecColumnKey &key)
+{
+   sampleCount numSamples = sequence->GetNumSamples();
+   if (centre <= 0 || centre >= numSamples)
+      return;
+
+   // The samples GetSpectrogram() reads for it, and the zeros before them
+   sampleCount start = centre - (windowSize >> 1);
+   sampleCount pad = 0;
+   if (start < 0) {
+      pad = -start;
+      start = 0;
+   }
+   sampleCount len = wxMin((sampleCount)bufferLen - pad, numSamples - start);
+
+   key = settingsKey;
+   key.push_back(pad);
+   if (!sequence->GetContentKey(start, len, key))
+      key.clear();
+}
+
+static void AddSpecColumn(const SpecColumnKey &key, const float *column,
+                          int half)
+{
+   if (half <= 0)
+      return;
+
+   sSpecColumnMutex.Lock();
+   if (sSpecColumnIndex.find(key) != sSpecColumnIndex.end()) {
+      sSpecColumnMutex.Unlock();
+      return;
+   }
+
+   // Forget the least recently used columns to stay within budget
+   while (!sSpecColumns.empty() &&
+          sSpecColumnFloats + half > SPEC_COLUMN_CACHE_FLOATS) {
+      SpecColumn &oldest = sSpecColumns.front();
+      sSpecColumnIndex.erase(oldest.key);
+      delete[] oldest.data;
+      sSpecColumnFloats -= oldest.half;
+      sSpecColumns.pop_front();
+   }
+
+   SpecColumn entry;
+   entry.key = key;
+   entry.data = new float[half];
+   entry.half = half;
+   memcpy(entry.data, column, half * sizeof(float));
+   sSpecColumnIndex[key] = sSpecColumns.insert(sSpecColumns.end(), entry);
+   sSpecColumnFloats += half;
+   sSpecColumnMutex.Unlock();
+}
+
 #ifdef EXPERIMENTAL_USE_REALFFTF
 #include "FFT.h"
 static void ComputeSpectrumUsingRealFFTf(float *buffer, HFFT hFFT, float *window, int len, float *out)
@@ -288,8 +553,280 @@ static void ComputeSpectrumUsingRealFFTf(float *buffer, HFFT hFFT, float *window
          out[i] = 10.0*log10f(power);
    }
 }
+
+// Builds the window for the spectrogram's FFTs, scaled to give a 0dB
+// spectrum for a 0dB sine tone
+static float *NewSpectrumWindow(int windowType, int windowSize)
+{
+   float *window = new float[windowSize];
+   int i;
+   for(i=0; i<windowSize; i++)
+      window[i]=1.0;
+   WindowFunc(windowType, windowSize, window);
+   double ws=0;
+   for(i=0; i<windowSize; i++)
+      ws += window[i];
+   if(ws > 0) {
+      ws = 2.0/ws;
+      for(i=0; i<windowSize; i++)
+         window[i] *= ws;
+   }
+   return window;
+}
+
+// Spectrogram columns that are not in the column cache are read on the
+// drawing thread and handed to a pool of worker threads in jobs, so that
+// drawing doesn't wait for the FFTs.  Until the workers are done the clip
+// shows those columns blank.  A worker puts each job's columns in the
+// column cache and asks the projects to repaint, and the clip picks them
+// up from there on the next draw.
+//
+// The workers never read samples or touch a clip, so a clip may go away
+// while its columns are being worked out.  The clip pointer is only kept
+// to drop the jobs it no longer needs when its view moves on.  Columns
+// turned away because the queue is full are asked for again on the
+// repaint that follows the next finished job.
+#define SPECTRUM_JOB_COLUMNS 64
+#define SPECTRUM_QUEUE_FLOATS (1 << 22)   // 16MB of queued samples
+
+DEFINE_EVENT_TYPE(EVT_SPECTRUM_COLUMNS_READY)
+
+struct SpectrumJob {
+   SpectrumJob(const WaveClip *owner, int type, int size, int bufLen,
+               const float *gain)
+   {
+      clip = owner;
+      windowType = type;
+      windowSize = size;
+      bufferLen = bufLen;
+      gainfactor = NULL;
+      if (gain) {
+         gainfactor = new float[windowSize / 2];
+         memcpy(gainfactor, gain, (windowSize / 2) * sizeof(float));
+      }
+      buffers = new float[SPECTRUM_JOB_COLUMNS * bufferLen];
+   }
+
+   ~SpectrumJob()
+   {
+      delete[] gainfactor;
+      delete[] buffers;
+   }
+
+   const WaveClip *clip;
+   int windowType;
+   int windowSize;
+   int bufferLen;
+   float *gainfactor;
+   float *buffers;                   // one bufferLen per key
+   std::vector<SpecColumnKey> keys;
+};
+
+class SpectrumWorker;
+
+static std::deque<SpectrumJob *> sSpectrumJobs;
+static std::set<SpecColumnKey> sSpectrumPending;   // queued or being done
+static size_t sSpectrumQueuedFloats = 0;
+static std::vector<SpectrumWorker *> sSpectrumWorkers;
+static bool sSpectrumWorkersStarted = false;
+static bool sSpectrumQuit = false;
+static ODLock sSpectrumJobsMutex;
+static ODCondition *sSpectrumJobsCond = NULL;
+
+static SpectrumJob *NextSpectrumJob()
+{
+   SpectrumJob *job = NULL;
+   sSpectrumJobsMutex.Lock();
+   while (!sSpectrumQuit && sSpectrumJobs.empty())
+      sSpectrumJobsCond->Wait();
+   if (!sSpectrumQuit) {
+      job = sSpectrumJobs.front();
+      sSpectrumJobs.pop_front();
+   }
+   sSpectrumJobsMutex.Unlock();
+   return job;
+}
+
+static void FinishSpectrumJob(SpectrumJob *job)
+{
+   sSpectrumJobsMutex.Lock();
+   for (size_t j = 0; j < job->keys.size(); j++)
+      sSpectrumPending.erase(job->keys[j]);
+   sSpectrumQueuedFloats -= job->keys.size() * job->bufferLen;
+   sSpectrumJobsMutex.Unlock();
+   delete job;
+
+   wxCommandEvent event(EVT_SPECTRUM_COLUMNS_READY);
+   AudacityProject::AllProjectsDeleteLock();
+   for (size_t i = 0; i < gAudacityProjects.GetCount(); i++)
+      gAudacityProjects[i]->GetEventHandler()->AddPendingEvent(event);
+   AudacityProject::AllProjectsDeleteUnlock();
+}
+
+class SpectrumWorker : public wxThread
+{
+ public:
+   SpectrumWorker()
+      : wxThread(wxTHREAD_JOINABLE)
+   {
+      mHFFT = NULL;
+      mWindow = NULL;
+      mWindowType = -1;
+      mWindowSize = -1;
+   }
+
+   virtual ~SpectrumWorker()
+   {
+      if (mHFFT)
+         EndFFT(mHFFT);
+      delete[] mWindow;
+   }
+
+   virtual void *Entry()
+   {
+      SpectrumJob *job;
+      while ((job = NextSpectrumJob()) != NULL) {
+         Compute(job);
+         FinishSpectrumJob(job);
+      }
+      return NULL;
+   }
+
+ private:
+   void Compute(SpectrumJob *job)
+   {
+      // Each worker has its own FFT tables and window, made again only
+      // when the settings change
+      if (job->windowType != mWindowType || job->windowSize != mWindowSize) {
+         mWindowType = job->windowType;
+         mWindowSize = job->windowSize;
+         if (mHFFT)
+            EndFFT(mHFFT);
+         mHFFT = InitializeFFT(mWindowSize);
+         delete[] mWindow;
+         mWindow = NewSpectrumWindow(mWindowType, mWindowSize);
+      }
+
+      int half = mWindowSize / 2;
+      float *out = new float[half];
+      for (size_t j = 0; j < job->keys.size(); j++) {
+         ComputeSpectrumUsingRealFFTf(&job->buffers[j * job->bufferLen],
+                                      mHFFT, mWindow, mWindowSize, out);
+         if (job->gainfactor) {
+            // Apply a frequency-dependant gain factor
+            for (int i = 0; i < half; i++)
+               out[i] += job->gainfactor[i];
+         }
+         AddSpecColumn(job->keys[j], out, half);
+      }
+      delete[] out;
+   }
+
+   HFFT mHFFT;
+   float *mWindow;
+   int mWindowType;
+   int mWindowSize;
+};
+
+// Starts the workers the first time they are wanted.  Only the thread
+// that draws the track panel asks.  Returns false if none could be run,
+// when the columns must be worked out where they are asked for.
+static bool StartSpectrumWorkers()
+{
+   if (!sSpectrumWorkersStarted) {
+      sSpectrumWorkersStarted = true;
+      sSpectrumJobsCond = new ODCondition(&sSpectrumJobsMutex);
+      int numThreads = wxMax(1, wxThread::GetCPUCount());
+      for (int t = 0; t < numThreads; t++) {
+         SpectrumWorker *worker = new SpectrumWorker();
+         if (worker->Create() != wxTHREAD_NO_ERROR ||
+             worker->Run() != wxTHREAD_NO_ERROR) {
+            delete worker;
+            break;
+         }
+         sSpectrumWorkers.push_back(worker);
+      }
+   }
+   return !sSpectrumWorkers.empty();
+}
+
+// Claims a column for the workers.  Returns false if it is already queued
+// or being worked out, or if the queue is full; a later draw, after the
+// workers have caught up, asks again.
+static bool ClaimSpectrumColumn(const SpecColumnKey &key, int bufferLen)
+{
+   bool claimed = false;
+   sSpectrumJobsMutex.Lock();
+   if (sSpectrumQueuedFloats + bufferLen <= SPECTRUM_QUEUE_FLOATS &&
+       sSpectrumPending.insert(key).second) {
+      sSpectrumQueuedFloats += bufferLen;
+      claimed = true;
+   }
+   sSpectrumJobsMutex.Unlock();
+   return claimed;
+}
+
+static void QueueSpectrumJob(SpectrumJob *job)
+{
+   sSpectrumJobsMutex.Lock();
+   sSpectrumJobs.push_back(job);
+   sSpectrumJobsCond->Signal();
+   sSpectrumJobsMutex.Unlock();
+}
+
+// Drops the jobs a clip queued for a view it has since left, unless a
+// worker has already started them
+static void DropSpectrumJobs(const WaveClip *clip)
+{
+   if (!sSpectrumWorkersStarted)
+      return;
+
+   sSpectrumJobsMutex.Lock();
+   std::deque<SpectrumJob *>::iterator it = sSpectrumJobs.begin();
+   while (it != sSpectrumJobs.end()) {
+      SpectrumJob *job = *it;
+      if (job->clip == clip) {
+         for (size_t j = 0; j < job->keys.size(); j++)
+            sSpectrumPending.erase(job->keys[j]);
+         sSpectrumQueuedFloats -= job->keys.size() * job->bufferLen;
+         delete job;
+         it = sSpectrumJobs.erase(it);
+      }
+      else
+         ++it;
+   }
+   sSpectrumJobsMutex.Unlock();
+}
 #endif // EXPERIMENTAL_USE_REALFFTF
 
+void WaveClip::StopSpectrumWorkers()
+{
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   if (!sSpectrumWorkersStarted)
+      return;
+
+   sSpectrumJobsMutex.Lock();
+   sSpectrumQuit = true;
+   sSpectrumJobsCond->Broadcast();
+   sSpectrumJobsMutex.Unlock();
+
+   for (size_t t = 0; t < sSpectrumWorkers.size(); t++) {
+      sSpectrumWorkers[t]->Wait();
+      delete sSpectrumWorkers[t];
+   }
+   sSpectrumWorkers.clear();
+
+   for (size_t j = 0; j < sSpectrumJobs.size(); j++)
+      delete sSpectrumJobs[j];
+   sSpectrumJobs.clear();
+   sSpectrumPending.clear();
+   sSpectrumQueuedFloats = 0;
+
+   delete sSpectrumJobsCond;
+   sSpectrumJobsCond = NULL;
+#endif // EXPERIMENTAL_USE_REALFFTF
+}
+
 WaveClip::WaveClip(DirManager *projDirManager, sampleFormat format, int rate)
 {
    mOffset = 0;
@@ -297,6 +834,7 @@ WaveClip::WaveClip(DirManager *projDirManager, sampleFormat format, int rate)
    mSequence = new Sequence(projDirManager, format);
    mEnvelope = new Envelope();
    mWaveCache = new WaveCache(1);
+   mWaveZoomCache = new WaveZoomCache();
 #ifdef EXPERIMENTAL_USE_REALFFTF
    mWindowType = -1;
    mWindowSize = -1;
@@ -325,6 +863,7 @@ WaveClip::WaveClip(WaveClip& orig, DirManager *projDirManager)
    mEnvelope->SetOffset(orig.GetOffset());
    mEnvelope->SetTrackLen(((double)orig.mSequence->GetNumSamples()) / orig.mRate);
    mWaveCache = new WaveCache(1);
+   mWaveZoomCache = new WaveZoomCache();
 #ifdef EXPERIMENTAL_USE_REALFFTF
    mWindowType = -1;
    mWindowSize = -1;
@@ -351,6 +890,7 @@ WaveClip::~WaveClip()
    mEnvelope = NULL;
 
    delete mWaveCache;
+   delete mWaveZoomCache;
    delete mSpecCache;
    delete mSpecPxCache;
 #ifdef EXPERIMENTAL_USE_REALFFTF
@@ -439,6 +979,7 @@ void WaveClip::DeleteWaveCache()
    if(mWaveCache!=NULL)
       delete mWaveCache;
    mWaveCache = new WaveCache(1);
+   mWaveZoomCache->Clear();
    mWaveCacheMutex.Unlock();
 }
 
@@ -448,6 +989,7 @@ void WaveClip::AddInvalidRegion(long startSample, long endSample)
    mWaveCacheMutex.Lock();
    if(mWaveCache!=NULL)
       mWaveCache->AddInvalidRegion(startSample,endSample);
+   mWaveZoomCache->Clear();
    mWaveCacheMutex.Unlock();
 }
 
@@ -684,6 +1226,28 @@ bool WaveClip::GetWaveDisplay(float *min, float *max, float *rms,int* bl,
             p1 = a;
       }
 
+      // Zoomed well out, and wholly within the sequence: merge columns
+      // from the zoom cache
+      double samplesPerPixel = mRate / pixelsPerSecond;
+      if (p1 > p0 && samplesPerPixel >= 256 &&
+          mWaveCache->where[p0] >= 0 &&
+          mWaveCache->where[p1] <= mSequence->GetNumSamples()) {
+         if (mWaveZoomCache->dirty != mDirty) {
+            mWaveZoomCache->Clear();
+            mWaveZoomCache->dirty = mDirty;
+         }
+         // About sixteen columns to a pixel, so that pixel edges are within
+         // a few percent of where they fall, but never finer than the
+         // summaries Sequence::GetWaveDisplay would read at this zoom
+         int level = (int)floor(log(samplesPerPixel / 16) / log(2.0));
+         if (samplesPerPixel >= 65536)
+            level = 16;
+         else if (level < 8)
+            level = 8;
+         if (mWaveZoomCache->Fill(mSequence, mWaveCache, p0, p1, level))
+            p1 = p0;
+      }
+
       if (p1 > p0) {
          if (!mSequence->GetWaveDisplay(&mWaveCache->min[p0],
                                         &mWaveCache->max[p0],
@@ -723,21 +1287,21 @@ bool WaveClip::GetWaveDisplay(float *min, float *max, float *rms,int* bl,
 bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
                                int numPixels,
                                double t0, double pixelsPerSecond,
-                               bool autocorrelation)
+                               bool autocorrelation, bool background)
 {
-   int minFreq = gPrefs->Read(wxT("/Spectrum/MinFreq"), 0L);
-   int maxFreq = gPrefs->Read(wxT("/Spectrum/MaxFreq"), 8000L);
-   int range = gPrefs->Read(wxT("/Spectrum/Range"), 80L);
-   int gain = gPrefs->Read(wxT("/Spectrum/Gain"), 20L);
-   int frequencygain = gPrefs->Read(wxT("/Spectrum/FrequencyGain"), 0L);
-   int windowType;
-   int windowSize = gPrefs->Read(wxT("/Spectrum/FFTSize"), 256);
+   const SpectrogramSettings &settings = SpectrogramSettings::defaults();
+   int minFreq = settings.minFreq;
+   int maxFreq = settings.maxFreq;
+   int range = settings.range;
+   int gain = settings.gain;
+   int frequencygain = settings.frequencyGain;
+   int windowType = settings.windowType;
+   int windowSize = settings.windowSize;
 #ifdef EXPERIMENTAL_FFT_SKIP_POINTS
-   int fftSkipPoints = gPrefs->Read(wxT("/Spectrum/FFTSkipPoints"), 0L);
+   int fftSkipPoints = settings.fftSkipPoints;
    int fftSkipPoints1 = fftSkipPoints+1;
 #endif //EXPERIMENTAL_FFT_SKIP_POINTS
    int half = windowSize/2;
-   gPrefs->Read(wxT("/Spectrum/WindowType"), &windowType, 3);
 
 #ifdef EXPERIMENTAL_USE_REALFFTF
    // Update the FFT and window if necessary
@@ -750,24 +1314,12 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
       hFFT = InitializeFFT(mWindowSize);
       if(mWindow != NULL) delete[] mWindow;
       // Create the requested window function
-      mWindow = new float[mWindowSize];
-      int i;
-      for(i=0; i<windowSize; i++)
-         mWindow[i]=1.0;
-      WindowFunc(mWindowType, mWindowSize, mWindow);
-      // Scale the window function to give 0dB spectrum for 0dB sine tone
-      double ws=0;
-      for(i=0; i<windowSize; i++)
-         ws += mWindow[i];
-      if(ws > 0) {
-         ws = 2.0/ws;
-         for(i=0; i<windowSize; i++)
-            mWindow[i] *= ws;
-      }
+      mWindow = NewSpectrumWindow(mWindowType, mWindowSize);
    }
 #endif // EXPERIMENTAL_USE_REALFFTF
 
-   if (mSpecCache &&
+   bool sameView =
+       mSpecCache &&
        mSpecCache->minFreqOld == minFreq &&
        mSpecCache->maxFreqOld == maxFreq &&
        mSpecCache->rangeOld == range &&
@@ -782,12 +1334,20 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
        mSpecCache->start == t0 &&
        mSpecCache->ac == autocorrelation &&
        mSpecCache->len >= numPixels &&
-       mSpecCache->pps == pixelsPerSecond) {
+       mSpecCache->pps == pixelsPerSecond;
+
+   if (sameView && mSpecCache->numPending == 0) {
       memcpy(freq, mSpecCache->freq, numPixels*half*sizeof(float));
       memcpy(where, mSpecCache->where, (numPixels+1)*sizeof(sampleCount));
       return false;  //hit cache completely
    }
 
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   // Whatever was queued for a view we have left is no longer wanted
+   if (!sameView)
+      DropSpectrumJobs(this);
+#endif // EXPERIMENTAL_USE_REALFFTF
+
    SpecCache *oldCache = mSpecCache;
 
    mSpecCache = new SpecCache(numPixels, half, autocorrelation);
@@ -833,8 +1393,10 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
                       (mSpecCache->where[x] - oldCache->where[0]))
                        / (oldCache->where[oldCache->len] -
                                              oldCache->where[0]) + 0.5);
+            // Columns still blank there are looked for again below
             if (ox >= 0 && ox < oldCache->len &&
-                mSpecCache->where[x] == oldCache->where[ox]) {
+                mSpecCache->where[x] == oldCache->where[ox] &&
+                !oldCache->pending[ox]) {
 
                for (sampleCount i = 0; i < (sampleCount)half; i++)
                   mSpecCache->freq[half * x + i] =
@@ -846,11 +1408,13 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
    }
 
 #ifdef EXPERIMENTAL_FFT_SKIP_POINTS
-   float *buffer = new float[windowSize*fftSkipPoints1];
+   int bufferLen = windowSize*fftSkipPoints1;
    mSpecCache->fftSkipPointsOld = fftSkipPoints;
 #else //!EXPERIMENTAL_FFT_SKIP_POINTS
-   float *buffer = new float[windowSize];
+   int bufferLen = windowSize;
 #endif //EXPERIMENTAL_FFT_SKIP_POINTS
+
+   float *buffer = new float[bufferLen];
    mSpecCache->minFreqOld = minFreq;
    mSpecCache->maxFreqOld = maxFreq;
    mSpecCache->gainOld = gain;
@@ -859,6 +1423,27 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
    mSpecCache->windowSizeOld = windowSize;
    mSpecCache->frequencyGainOld = frequencygain;
 
+   // Pick up any columns seen before, at another zoom or scroll position
+   // or before an edit elsewhere, or finished by the spectrum workers
+   SpecColumnKey settingsKey;
+   settingsKey.push_back(windowSize);
+   settingsKey.push_back(windowType);
+   settingsKey.push_back(frequencygain);
+#ifdef EXPERIMENTAL_FFT_SKIP_POINTS
+   settingsKey.push_back(fftSkipPoints);
+#endif //EXPERIMENTAL_FFT_SKIP_POINTS
+   settingsKey.push_back(autocorrelation);
+   settingsKey.push_back(mRate);
+   std::vector<SpecColumnKey> keys(mSpecCache->len);
+   for (x = 0; x < mSpecCache->len; x++)
+      if (recalc[x]) {
+         MakeSpecColumnKey(mSequence, settingsKey, mSpecCache->where[x],
+                           windowSize, bufferLen, keys[x]);
+         if (!keys[x].empty() &&
+             FindSpecColumn(keys[x], &mSpecCache->freq[half * x]))
+            recalc[x] = false;
+      }
+
    float *gainfactor = NULL;
    if(frequencygain > 0) {
       // Compute a frequency-dependant gain factor
@@ -870,6 +1455,17 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
       }
    }
 
+   // The rest go to the spectrum workers, if they can take them.  Only
+   // columns with a key can: that is how the workers hand them back.
+   // Autocorrelation uses FFT(), whose tables are not safe to share
+   // between threads.
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   background = background && !autocorrelation && StartSpectrumWorkers();
+   SpectrumJob *job = NULL;
+#else // !EXPERIMENTAL_USE_REALFFTF
+   background = false;
+#endif // EXPERIMENTAL_USE_REALFFTF
+
    for (x = 0; x < mSpecCache->len; x++)
       if (recalc[x]) {
 
@@ -882,67 +1478,109 @@ bool WaveClip::GetSpectrogram(float *freq, sampleCount *where,
             for (i = 0; i < (sampleCount)half; i++)
                mSpecCache->freq[half * x + i] = 0;
 
+            continue;
+         }
+
+         bool queued = false;
+         if (background && !keys[x].empty()) {
+            // Blank until the workers have it
+            for (i = 0; i < (sampleCount)half; i++)
+               mSpecCache->freq[half * x + i] = -160.0;
+            mSpecCache->pending[x] = true;
+            mSpecCache->numPending++;
+            recalc[x] = false;
+
+#ifdef EXPERIMENTAL_USE_REALFFTF
+            // Unless it is already on its way, or the queue is full
+            if (!ClaimSpectrumColumn(keys[x], bufferLen))
+               continue;
+            if (!job)
+               job = new SpectrumJob(this, windowType, windowSize,
+                                     bufferLen, gainfactor);
+            queued = true;
+#endif // EXPERIMENTAL_USE_REALFFTF
+         }
+
+         float *adj = buffer;
+#ifdef EXPERIMENTAL_USE_REALFFTF
+         if (queued)
+            adj = &job->buffers[job->keys.size() * bufferLen];
+#endif // EXPERIMENTAL_USE_REALFFTF
+         float *columnBuffer = adj;
+         start -= windowSize >> 1;
+
+         if (start < 0) {
+            for (i = start; i < 0; i++)
+               *adj++ = 0;
+            len += start;
+            start = 0;
          }
-         else
-         {
-            float *adj = buffer;
-            start -= windowSize >> 1;
-
-            if (start < 0) {
-               for (i = start; i < 0; i++)
-                  *adj++ = 0;
-               len += start;
-               start = 0;
-            }
 #ifdef EXPERIMENTAL_FFT_SKIP_POINTS
-            if (start + len*fftSkipPoints1 > mSequence->GetNumSamples()) {
-               int newlen = (mSequence->GetNumSamples() - start)/fftSkipPoints1;
-               for (i = newlen*fftSkipPoints1; i < (sampleCount)len*fftSkipPoints1; i++)
+         if (start + len*fftSkipPoints1 > mSequence->GetNumSamples()) {
+            int newlen = (mSequence->GetNumSamples() - start)/fftSkipPoints1;
+            for (i = newlen*fftSkipPoints1; i < (sampleCount)len*fftSkipPoints1; i++)
 #else //!EXPERIMENTAL_FFT_SKIP_POINTS
-            if (start + len > mSequence->GetNumSamples()) {
-               int newlen = mSequence->GetNumSamples() - start;
-               for (i = newlen; i < (sampleCount)len; i++)
+         if (start + len > mSequence->GetNumSamples()) {
+            int newlen = mSequence->GetNumSamples() - start;
+            for (i = newlen; i < (sampleCount)len; i++)
 #endif //EXPERIMENTAL_FFT_SKIP_POINTS
-                  adj[i] = 0;
-               len = newlen;
-            }
+               adj[i] = 0;
+            len = newlen;
+         }
 
-            if (len > 0)
+         if (len > 0)
 #ifdef EXPERIMENTAL_FFT_SKIP_POINTS
-               mSequence->Get((samplePtr)adj, floatSample, start, len*fftSkipPoints1);
-            if (fftSkipPoints) {
-               // TODO: (maybe) alternatively change Get to include skipping of points
-               int j=0;
-               for (int i=0; i < len; i++) {
-                  adj[i]=adj[j];
-                  j+=fftSkipPoints1;
-               }
+            mSequence->Get((samplePtr)adj, floatSample, start, len*fftSkipPoints1);
+         if (fftSkipPoints) {
+            // TODO: (maybe) alternatively change Get to include skipping of points
+            int j=0;
+            for (int i=0; i < len; i++) {
+               adj[i]=adj[j];
+               j+=fftSkipPoints1;
             }
+         }
 #else //!EXPERIMENTAL_FFT_SKIP_POINTS
-               mSequence->Get((samplePtr)adj, floatSample, start, len);
+            mSequence->Get((samplePtr)adj, floatSample, start, len);
 #endif //EXPERIMENTAL_FFT_SKIP_POINTS
 
 #ifdef EXPERIMENTAL_USE_REALFFTF
-            if(autocorrelation) {
-               ComputeSpectrum(buffer, windowSize, windowSize,
-                               mRate, &mSpecCache->freq[half * x],
-                               autocorrelation, windowType);
-            } else {
-               ComputeSpectrumUsingRealFFTf(buffer, hFFT, mWindow, mWindowSize, &mSpecCache->freq[half * x]);
+         if (queued) {
+            job->keys.push_back(keys[x]);
+            if (job->keys.size() == SPECTRUM_JOB_COLUMNS) {
+               QueueSpectrumJob(job);
+               job = NULL;
             }
+            continue;
+         }
+
+         if(autocorrelation) {
+            ComputeSpectrum(columnBuffer, windowSize, windowSize,
+                            mRate, &mSpecCache->freq[half * x],
+                            autocorrelation, windowType);
+         } else {
+            ComputeSpectrumUsingRealFFTf(columnBuffer, hFFT, mWindow, mWindowSize, &mSpecCache->freq[half * x]);
+         }
 #else  // EXPERIMENTAL_USE_REALFFTF
-           ComputeSpectrum(buffer, windowSize, windowSize,
-                           mRate, &mSpecCache->freq[half * x],
-                           autocorrelation, windowType);
+         ComputeSpectrum(columnBuffer, windowSize, windowSize,
+                         mRate, &mSpecCache->freq[half * x],
+                         autocorrelation, windowType);
 #endif // EXPERIMENTAL_USE_REALFFTF
-           if(gainfactor) {
-              // Apply a frequency-dependant gain factor
-              for(i=0; i<half; i++)
-                 mSpecCache->freq[half * x + i] += gainfactor[i];
-           }
+         if(gainfactor) {
+            // Apply a frequency-dependant gain factor
+            for(i=0; i<half; i++)
+               mSpecCache->freq[half * x + i] += gainfactor[i];
          }
       }
 
+#ifdef EXPERIMENTAL_USE_REALFFTF
+   if (job)
+      QueueSpectrumJob(job);
+#endif // EXPERIMENTAL_USE_REALFFTF
+
+   for (x = 0; x < mSpecCache->len; x++)
+      if (recalc[x] && !keys[x].empty())
+         AddSpecColumn(keys[x], &mSpecCache->freq[half * x], half);
+
    if(gainfactor)
       delete[] gainfactor;
    delete[]buffer;
@@ -994,6 +1632,12 @@ bool WaveClip::GetRMS(float *rms, double t0,
    return mSequence->GetRMS(s0, s1-s0, rms);
 }
 
+bool WaveClip::GetStatistics(SampleStats *stats,
+                             sampleCount start, sampleCount len) const
+{
+   return mSequence->GetStatistics(start, len, stats);
+}
+
 void WaveClip::ConvertToSampleFormat(sampleFormat format)
 {
    bool bChanged;
@@ -1608,6 +2252,7 @@ bool WaveClip::Resample(int rate, ProgressDialog *progress)
          mWaveCache = NULL;
       }
       mWaveCache = new WaveCache(1);
+      mWaveZoomCache->Clear();
       // Invalidate the spectrum display cache
       if (mSpecCache)
          delete mSpecCache;
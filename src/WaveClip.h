@@ -29,8 +29,11 @@
 #include <wx/list.h>
 #include <wx/msgdlg.h>
 
+DECLARE_EXPORTED_EVENT_TYPE(AUDACITY_DLL_API, EVT_SPECTRUM_COLUMNS_READY, -1)
+
 class Envelope;
 class WaveCache;
+class WaveZoomCache;
 class SpecCache;
 
 class SpecPxCache {
@@ -140,12 +143,20 @@ public:
     * calculations and Contrast */
    bool GetWaveDisplay(float *min, float *max, float *rms,int* bl, sampleCount *where,
                        int numPixels, double t0, double pixelsPerSecond, bool &isLoadingOD);
+   /// With background, columns not yet computed are left blank and handed
+   /// to the spectrum worker threads, and EVT_SPECTRUM_COLUMNS_READY asks
+   /// the projects to repaint when they are done; returns true while any
+   /// are still blank.  Without it, waits for every column.
    bool GetSpectrogram(float *buffer, sampleCount *where,
                        int numPixels,
                        double t0, double pixelsPerSecond,
-                       bool autocorrelation);
+                       bool autocorrelation, bool background);
+   /// Stops the spectrum worker threads; call once, on exit
+   static void StopSpectrumWorkers();
    bool GetMinMax(float *min, float *max, double t0, double t1);
    bool GetRMS(float *rms, double t0, double t1);
+   bool GetStatistics(SampleStats *stats,
+                      sampleCount start, sampleCount len) const;
 
    // Set/clear/get rectangle that this WaveClip fills on screen. This is
    // called by TrackArtist while actually drawing the tracks and clips.
@@ -246,6 +257,7 @@ protected:
    Envelope *mEnvelope;
 
    WaveCache    *mWaveCache;
+   WaveZoomCache *mWaveZoomCache;
    ODLock       mWaveCacheMutex;
    SpecCache    *mSpecCache;
 #ifdef EXPERIMENTAL_USE_REALFFTF
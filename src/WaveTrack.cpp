@@ -42,6 +42,7 @@ Track classes.
 
 #include "Envelope.h"
 #include "Sequence.h"
+#include "BlockFile.h"
 #include "Spectrum.h"
 
 #include "Project.h"
@@ -1734,6 +1735,64 @@ bool WaveTrack::GetRMS(float *rms, double t0, double t1)
    return result;
 }
 
+// Gathers exact statistics over the samples [start, start+len) of the
+// track, as Get() would return them: samples between clips count as
+// zeros.
+bool WaveTrack::GetStatistics(SampleStats *stats, sampleCount start, sampleCount len)
+{
+   stats->Clear();
+
+   if (len < 0)
+      return false;
+
+   if (len == 0)
+      return true;
+
+   bool result = true;
+   sampleCount covered = 0;
+
+   for (WaveClipList::compatibility_iterator it=GetClipIterator(); it; it=it->GetNext())
+   {
+      WaveClip* clip = it->GetData();
+
+      sampleCount clipStart = clip->GetStartSample();
+      sampleCount clipEnd = clip->GetEndSample();
+
+      if (clipEnd > start && clipStart < start+len)
+      {
+         // Same overlap as Get() works out
+         sampleCount samplesToCopy = start+len - clipStart;
+         if (samplesToCopy > clip->GetNumSamples())
+            samplesToCopy = clip->GetNumSamples();
+         sampleCount inclipDelta = 0;
+         if (clipStart < start)
+         {
+            inclipDelta = start - clipStart;
+            samplesToCopy -= inclipDelta;
+         }
+
+         SampleStats clipStats;
+
+         if (clip->GetStatistics(&clipStats, inclipDelta, samplesToCopy))
+            stats->Add(clipStats);
+         else
+            result = false;
+
+         covered += samplesToCopy;
+      }
+   }
+
+   if (covered < len)
+   {
+      SampleStats gap;
+      gap.count = len - covered;
+      gap.min = gap.max = 0.0f;
+      stats->Add(gap);
+   }
+
+   return result;
+}
+
 bool WaveTrack::Get(samplePtr buffer, sampleFormat format,
                     sampleCount start, sampleCount len, fillFormat fill )
 {
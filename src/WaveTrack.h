@@ -239,6 +239,7 @@ class AUDACITY_DLL_API WaveTrack: public Track {
    bool GetMinMax(float *min, float *max,
                   double t0, double t1);
    bool GetRMS(float *rms, double t0, double t1);
+   bool GetStatistics(SampleStats *stats, sampleCount start, sampleCount len);
 
    //
    // MM: We now have more than one sequence and envelope per track, so
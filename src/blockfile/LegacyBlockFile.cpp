@@ -69,10 +69,9 @@ void ComputeLegacySummaryInfo(wxFileName fileName,
    samplePtr data = NewSamples(info->frames64K * fields,
                                info->format);
 
-   wxLogNull *silence=0;
    wxFFile summaryFile(fileName.GetFullPath(), wxT("rb"));
    int read;
-   if(Silent)silence= new wxLogNull();
+   BlockFileSilencer silence(Silent);
 
    if( !summaryFile.IsOpened() ) {
       wxLogWarning(wxT("Unable to access summary file %s; substituting silence for remainder of session"),
@@ -87,7 +86,7 @@ void ComputeLegacySummaryInfo(wxFileName fileName,
                               info->bytesPerFrame);
    }
 
-   if(silence) delete silence;
+   silence.Release();
 
    int count = read / info->bytesPerFrame;
 
@@ -152,14 +151,13 @@ LegacyBlockFile::~LegacyBlockFile()
 bool LegacyBlockFile::ReadSummary(void *data)
 {
    wxFFile summaryFile(mFileName.GetFullPath(), wxT("rb"));
-   wxLogNull *silence=0;
-   if(mSilentLog)silence= new wxLogNull();
+   BlockFileSilencer silence(mSilentLog);
 
    if( !summaryFile.IsOpened() ){
 
       memset(data,0,(size_t)mSummaryInfo.totalSummaryBytes);
 
-      if(silence) delete silence;
+      silence.Release();
       mSilentLog=TRUE;
 
       return true;
@@ -167,7 +165,7 @@ bool LegacyBlockFile::ReadSummary(void *data)
 
    int read = summaryFile.Read(data, (size_t)mSummaryInfo.totalSummaryBytes);
 
-   if(silence) delete silence;
+   silence.Release();
    mSilentLog=FALSE;
 
    return (read == mSummaryInfo.totalSummaryBytes);
@@ -216,19 +214,18 @@ int LegacyBlockFile::ReadData(samplePtr data, sampleFormat format,
       sf = sf_open_fd(f.fd(), SFM_READ, &info, FALSE);
    }
 
-   wxLogNull *silence=0;
-   if(mSilentLog)silence= new wxLogNull();
+   BlockFileSilencer silence(mSilentLog);
 
    if (!sf){
 
       memset(data,0,SAMPLE_SIZE(format)*len);
 
-      if(silence) delete silence;
+      silence.Release();
       mSilentLog=TRUE;
 
       return len;
    }
-   if(silence) delete silence;
+   silence.Release();
    mSilentLog=FALSE;
 
    sf_count_t seekstart = start +
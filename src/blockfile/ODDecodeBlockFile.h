@@ -113,6 +113,8 @@ class ODDecodeBlockFile : public SimpleBlockFile
 
    /// Read the summary into a buffer
    virtual bool ReadSummary(void *data);
+   /// Read part of the summary into a buffer
+   virtual bool ReadSummaryPart(void *data, int offset, int bytes);
 
    ///Returns the type of audiofile this blockfile is loaded from.
    virtual unsigned int GetDecodeType(){return mType;}
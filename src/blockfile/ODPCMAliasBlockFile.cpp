@@ -229,7 +229,7 @@ BlockFile *ODPCMAliasBlockFile::Copy(wxFileName newFileName)
                                                    mAliasedFileName, mAliasStart,
                                                    mLen, mAliasChannel,
                                                    mMin, mMax, mRMS);
-
+      CopyStats(newBlockFile);
    }
    else
    {
@@ -443,8 +443,9 @@ void ODPCMAliasBlockFile::WriteSummary()
 
 
 
-/// A thread-safe version of CalcSummary.  BlockFile::CalcSummary
-/// uses a static summary array across the class, which we can't use.
+/// A thread-safe version of CalcSummary.  This runs on an OD thread,
+/// so unlike BlockFile::CalcSummary it leaves mStats alone; they are
+/// worked out from the samples when first asked for.
 /// Get a buffer containing a summary block describing this sample
 /// data.  This must be called by derived classes when they
 /// are constructed, to allow them to construct their summary data,
@@ -453,9 +454,8 @@ void ODPCMAliasBlockFile::WriteSummary()
 /// This method also has the side effect of setting the mMin, mMax,
 /// and mRMS members of this class.
 ///
-/// Unlike BlockFile's implementation You SHOULD delete the returned buffer.
-/// this is protected so it shouldn't be hard to deal with - just override
-/// all BlockFile methods that use this method.
+/// As with BlockFile's implementation, you must delete[] the returned
+/// buffer.
 ///
 /// @param buffer A buffer containing the sample data to be analyzed
 /// @param len    The length of the sample data
@@ -467,9 +467,6 @@ void *ODPCMAliasBlockFile::CalcSummary(samplePtr buffer, sampleCount len,
 
    memcpy(localFullSummary, aheaderTag, aheaderTagLen);
 
-   float *summary64K = (float *)(localFullSummary + mSummaryInfo.offset64K);
-   float *summary256 = (float *)(localFullSummary + mSummaryInfo.offset256);
-
    float *fbuffer;
 
    //mchinen: think we can hack this - don't allocate and copy if we don't need to.,
@@ -483,95 +480,10 @@ void *ODPCMAliasBlockFile::CalcSummary(samplePtr buffer, sampleCount len,
       CopySamples(buffer, format,
                (samplePtr)fbuffer, floatSample, len);
    }
-   sampleCount sumLen;
-   sampleCount i, j, jcount;
-
-   float min, max;
-   float sumsq;
-
-   // Recalc 256 summaries
-   sumLen = (len + 255) / 256;
-
-
-   for (i = 0; i < sumLen; i++) {
-      min = fbuffer[i * 256];
-      max = fbuffer[i * 256];
-      sumsq = ((float)min) * ((float)min);
-      jcount = 256;
-      if (i * 256 + jcount > len)
-         jcount = len - i * 256;
-      for (j = 1; j < jcount; j++) {
-         float f1 = fbuffer[i * 256 + j];
-         sumsq += ((float)f1) * ((float)f1);
-         if (f1 < min)
-            min = f1;
-         else if (f1 > max)
-            max = f1;
-      }
-
-      float rms = (float)sqrt(sumsq / jcount);
-
-      summary256[i * 3] = min;
-      summary256[i * 3 + 1] = max;
-      summary256[i * 3 + 2] = rms;
-   }
-
-   for (i = sumLen; i < mSummaryInfo.frames256; i++) {
-      // filling in the remaining bits with non-harming/contributing values
-      summary256[i * 3] = FLT_MAX;  // min
-      summary256[i * 3 + 1] = -FLT_MAX;   // max
-      summary256[i * 3 + 2] = 0.0f; // rms
-   }
-
-   // Recalc 64K summaries
-   sumLen = (len + 65535) / 65536;
-
-   for (i = 0; i < sumLen; i++) {
-      min = summary256[3 * i * 256];
-      max = summary256[3 * i * 256 + 1];
-      sumsq = (float)summary256[3 * i * 256 + 2];
-      sumsq *= sumsq;
-
-      for (j = 1; j < 256; j++) {
-         if (summary256[3 * (i * 256 + j)] < min)
-            min = summary256[3 * (i * 256 + j)];
-         if (summary256[3 * (i * 256 + j) + 1] > max)
-            max = summary256[3 * (i * 256 + j) + 1];
-         float r1 = summary256[3 * (i * 256 + j) + 2];
-         sumsq += r1*r1;
-      }
-
-      float rms = (float)sqrt(sumsq / 256);
-
-      summary64K[i * 3] = min;
-      summary64K[i * 3 + 1] = max;
-      summary64K[i * 3 + 2] = rms;
-   }
-   for (i = sumLen; i < mSummaryInfo.frames64K; i++) {
-      summary64K[i * 3] = 0.0f;
-      summary64K[i * 3 + 1] = 0.0f;
-      summary64K[i * 3 + 2] = 0.0f;
-   }
-
-   // Recalc block-level summary
-   min = summary64K[0];
-   max = summary64K[1];
-   sumsq = (float)summary64K[2];
-   sumsq *= sumsq;
-
-   for (i = 1; i < sumLen; i++) {
-      if (summary64K[3*i] < min)
-         min = summary64K[3*i];
-      if (summary64K[3*i+1] > max)
-         max = summary64K[3*i+1];
-      float r1 = (float)summary64K[3*i+2];
-      sumsq += (r1*r1);
-   }
-
-   mMin = min;
-   mMax = max;
-   mRMS = sqrt(sumsq / sumLen);
 
+   CalcSummaryFromBuffer(fbuffer, len,
+      (float *)(localFullSummary + mSummaryInfo.offset256),
+      (float *)(localFullSummary + mSummaryInfo.offset64K));
 
    //if we've used the float sample..
    if(format!=floatSample)
@@ -722,6 +634,29 @@ bool ODPCMAliasBlockFile::ReadSummary(void *data)
    return (read == mSummaryInfo.totalSummaryBytes);
 }
 
+/// Read part of the summary file, without logging, as ReadSummary() does.
+bool ODPCMAliasBlockFile::ReadSummaryPart(void *data, int offset, int bytes)
+{
+   mFileNameMutex.Lock();
+   wxFFile summaryFile(mFileName.GetFullPath(), wxT("rb"));
+
+   if( !summaryFile.IsOpened() ){
+      memset(data,0,(size_t)bytes);
+      mSilentLog=TRUE;
+      mFileNameMutex.Unlock();
+      return true;
+   }else mSilentLog=FALSE;
+
+   int read = 0;
+   if (summaryFile.Seek(offset))
+      read = summaryFile.Read(data, (size_t)bytes);
+
+   FixSummaryPart(data, bytes / mSummaryInfo.bytesPerFrame);
+
+   mFileNameMutex.Unlock();
+   return (read == bytes);
+}
+
 /// Prevents a read on other threads.
 void ODPCMAliasBlockFile::LockRead()
 {
@@ -122,6 +122,8 @@ class ODPCMAliasBlockFile : public PCMAliasBlockFile
 
    /// Read the summary into a buffer
    virtual bool ReadSummary(void *data);
+   /// Read part of the summary into a buffer
+   virtual bool ReadSummaryPart(void *data, int offset, int bytes);
 
    ///sets the file name the summary info will be saved in.  threadsafe.
    virtual void SetFileName(wxFileName &name);
@@ -80,8 +80,7 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       return len;
    }
 
-   wxLogNull *silence=0;
-   if(mSilentAliasLog)silence= new wxLogNull();
+   BlockFileSilencer silence(mSilentAliasLog);
 
    memset(&info, 0, sizeof(info));
 
@@ -101,7 +100,7 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
 
    if (!sf){
       memset(data,0,SAMPLE_SIZE(format)*len);
-      if(silence) delete silence;
+      silence.Release();
       mSilentAliasLog=TRUE;
 
       // Set a marker to display an error message for the silence
@@ -110,7 +109,7 @@ int PCMAliasBlockFile::ReadData(samplePtr data, sampleFormat format,
       return len;
    }
 
-   if(silence) delete silence;
+   silence.Release();
    mSilentAliasLog=FALSE;
 
    ODManager::LockLibSndFileMutex();
@@ -163,6 +162,7 @@ BlockFile *PCMAliasBlockFile::Copy(wxFileName newFileName)
                                                    mAliasedFileName, mAliasStart,
                                                    mLen, mAliasChannel,
                                                    mMin, mMax, mRMS);
+   CopyStats(newBlockFile);
 
    return newBlockFile;
 }
@@ -179,6 +179,7 @@ void PCMAliasBlockFile::SaveXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("min"), mMin);
    xmlFile.WriteAttr(wxT("max"), mMax);
    xmlFile.WriteAttr(wxT("rms"), mRMS);
+   SaveStatsXML(xmlFile);
 
    xmlFile.EndTag(wxT("pcmaliasblockfile"));
 }
@@ -192,6 +193,9 @@ BlockFile *PCMAliasBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
    wxFileName aliasFileName;
    int aliasStart=0, aliasLen=0, aliasChannel=0;
    float min = 0.0f, max = 0.0f, rms = 0.0f;
+   double sum = 0.0, sumsq = 0.0;
+   long clipped = 0;
+   int statsFound = 0;
    double dblValue;
    long nValue;
 
@@ -239,6 +243,18 @@ BlockFile *PCMAliasBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
             max = nValue;
          else if (!wxStricmp(attr, wxT("rms")) && (nValue >= 0))
             rms = nValue;
+         else if (!wxStricmp(attr, wxT("sum"))) {
+            sum = nValue;
+            statsFound |= 1;
+         }
+         else if (!wxStricmp(attr, wxT("sumsq")) && (nValue >= 0)) {
+            sumsq = nValue;
+            statsFound |= 2;
+         }
+         else if (!wxStricmp(attr, wxT("clipped")) && (nValue >= 0)) {
+            clipped = nValue;
+            statsFound |= 4;
+         }
       }
       // mchinen: the min/max can be (are?) doubles as well, so handle those cases.
       // Vaughan: The code to which I added the XMLValueChecker checks
@@ -253,12 +269,24 @@ BlockFile *PCMAliasBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
             max = dblValue;
          else if (!wxStricmp(attr, wxT("rms")) && (dblValue >= 0.0))
             rms = dblValue;
+         else if (!wxStricmp(attr, wxT("sum"))) {
+            sum = dblValue;
+            statsFound |= 1;
+         }
+         else if (!wxStricmp(attr, wxT("sumsq")) && (dblValue >= 0.0)) {
+            sumsq = dblValue;
+            statsFound |= 2;
+         }
       }
    }
 
-   return new PCMAliasBlockFile(summaryFileName, aliasFileName,
-                                aliasStart, aliasLen, aliasChannel,
-                                min, max, rms);
+   BlockFile *blockFile =
+      new PCMAliasBlockFile(summaryFileName, aliasFileName,
+                            aliasStart, aliasLen, aliasChannel,
+                            min, max, rms);
+   if (statsFound == 7)
+      blockFile->RestoreStats(sum, sumsq, clipped);
+   return blockFile;
 }
 
 void PCMAliasBlockFile::Recover(void)
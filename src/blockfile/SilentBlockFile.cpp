@@ -17,6 +17,12 @@ SilentBlockFile::SilentBlockFile(sampleCount sampleLen):
    mMin = 0.;
    mMax = 0.;
    mRMS = 0.;
+
+   mStats.Clear();
+   mStats.count = sampleLen;
+   mStats.min = 0.;
+   mStats.max = 0.;
+   mStatsValid = true;
 }
 
 SilentBlockFile::~SilentBlockFile()
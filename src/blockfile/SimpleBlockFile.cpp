@@ -119,11 +119,8 @@ SimpleBlockFile::SimpleBlockFile(wxFileName baseFileName,
       mCache.sampleData = new char[sampleLen * SAMPLE_SIZE(format)];
       memcpy(mCache.sampleData,
              sampleData, sampleLen * SAMPLE_SIZE(format));
-      void* summaryData = BlockFile::CalcSummary(sampleData, sampleLen,
-                                                format);
-      mCache.summaryData = new char[mSummaryInfo.totalSummaryBytes];
-      memcpy(mCache.summaryData, summaryData,
-             (size_t)mSummaryInfo.totalSummaryBytes);
+      mCache.summaryData = BlockFile::CalcSummary(sampleData, sampleLen,
+                                                  format);
     }
 }
 
@@ -200,9 +197,6 @@ bool SimpleBlockFile::WriteSimpleBlockFile(
    header.channels = 1;
 
    // Write the file
-   if (!summaryData)
-      summaryData = /*BlockFile::*/CalcSummary(sampleData, sampleLen, format); //mchinen:allowing virtual override of calc summary for ODDecodeBlockFile.
-
    size_t nBytesToWrite = sizeof(header);
    size_t nBytesWritten = file.Write(&header, nBytesToWrite);
    if (nBytesWritten != nBytesToWrite)
@@ -211,8 +205,13 @@ bool SimpleBlockFile::WriteSimpleBlockFile(
       return false;
    }
 
+   char *ownSummaryData = NULL;
+   if (!summaryData)
+      summaryData = ownSummaryData = (char *)/*BlockFile::*/CalcSummary(sampleData, sampleLen, format); //mchinen:allowing virtual override of calc summary for ODDecodeBlockFile.
+
    nBytesToWrite = mSummaryInfo.totalSummaryBytes;
    nBytesWritten = file.Write(summaryData, nBytesToWrite);
+   delete[] ownSummaryData;
    if (nBytesWritten != nBytesToWrite)
    {
       wxLogDebug(wxT("Wrote %lld bytes, expected %lld."), (long long) nBytesWritten, (long long) nBytesToWrite);
@@ -340,21 +339,20 @@ bool SimpleBlockFile::ReadSummary(void *data)
 
       wxFFile file(mFileName.GetFullPath(), wxT("rb"));
 
-      wxLogNull *silence=0;
-      if(mSilentLog)silence= new wxLogNull();
+      BlockFileSilencer silence(mSilentLog);
 
       if(!file.IsOpened() ){
 
          memset(data,0,(size_t)mSummaryInfo.totalSummaryBytes);
 
-         if(silence) delete silence;
+         silence.Release();
          mSilentLog=TRUE;
 
          return true;
 
       }
 
-      if(silence) delete silence;
+      silence.Release();
       mSilentLog=FALSE;
 
       // The offset is just past the au header
@@ -369,6 +367,49 @@ bool SimpleBlockFile::ReadSummary(void *data)
    }
 }
 
+/// Read part of the summary section, from the cache or by seeking to it
+/// in the disk file.
+///
+/// @param *data  The buffer to write the data to
+/// @param offset Offset of the first byte within the summary section
+/// @param bytes  Number of bytes to read
+bool SimpleBlockFile::ReadSummaryPart(void *data, int offset, int bytes)
+{
+   if (mCache.active)
+   {
+      memcpy(data, (char *)mCache.summaryData + offset, (size_t)bytes);
+      return true;
+   }
+
+   wxFFile file(mFileName.GetFullPath(), wxT("rb"));
+
+   BlockFileSilencer silence(mSilentLog);
+
+   if(!file.IsOpened() ){
+
+      memset(data,0,(size_t)bytes);
+
+      silence.Release();
+      mSilentLog=TRUE;
+
+      return true;
+
+   }
+
+   silence.Release();
+   mSilentLog=FALSE;
+
+   // The summary starts just past the au header
+   if( !file.Seek(sizeof(auHeader) + offset) )
+      return false;
+
+   int read = (int)file.Read(data, (size_t)bytes);
+
+   FixSummaryPart(data, bytes / mSummaryInfo.bytesPerFrame);
+
+   return (read == bytes);
+}
+
 /// Read the data portion of the block file using libsndfile.  Convert it
 /// to the given format if it is not already.
 ///
@@ -395,8 +436,7 @@ int SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
       //wxLogDebug("SimpleBlockFile::ReadData(): Reading data from disk.");
 
       SF_INFO info;
-      wxLogNull *silence=0;
-      if(mSilentLog)silence= new wxLogNull();
+      BlockFileSilencer silence(mSilentLog);
 
       memset(&info, 0, sizeof(info));
 
@@ -414,12 +454,12 @@ int SimpleBlockFile::ReadData(samplePtr data, sampleFormat format,
 
          memset(data,0,SAMPLE_SIZE(format)*len);
 
-         if(silence) delete silence;
+         silence.Release();
          mSilentLog=TRUE;
 
          return len;
       }
-      if(silence) delete silence;
+      silence.Release();
       mSilentLog=FALSE;
 
       sf_seek(sf, start, SEEK_SET);
@@ -473,6 +513,7 @@ void SimpleBlockFile::SaveXML(XMLWriter &xmlFile)
    xmlFile.WriteAttr(wxT("min"), mMin);
    xmlFile.WriteAttr(wxT("max"), mMax);
    xmlFile.WriteAttr(wxT("rms"), mRMS);
+   SaveStatsXML(xmlFile);
 
    xmlFile.EndTag(wxT("simpleblockfile"));
 }
@@ -486,6 +527,9 @@ BlockFile *SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
    wxFileName fileName;
    float min = 0.0f, max = 0.0f, rms = 0.0f;
    sampleCount len = 0;
+   double sum = 0.0, sumsq = 0.0;
+   long clipped = 0;
+   int statsFound = 0;
    double dblValue;
    long nValue;
 
@@ -518,10 +562,25 @@ BlockFile *SimpleBlockFile::BuildFromXML(DirManager &dm, const wxChar **attrs)
             max = dblValue;
          else if (!wxStricmp(attr, wxT("rms")) && (dblValue >= 0.0))
             rms = dblValue;
+         else if (!wxStricmp(attr, wxT("sum"))) {
+            sum = dblValue;
+            statsFound |= 1;
+         }
+         else if (!wxStricmp(attr, wxT("sumsq")) && (dblValue >= 0.0)) {
+            sumsq = dblValue;
+            statsFound |= 2;
+         }
+         else if (!wxStricmp(attr, wxT("clipped")) && (dblValue >= 0.0)) {
+            clipped = (long)dblValue;
+            statsFound |= 4;
+         }
       }
    }
 
-   return new SimpleBlockFile(fileName, len, min, max, rms);
+   BlockFile *blockFile = new SimpleBlockFile(fileName, len, min, max, rms);
+   if (statsFound == 7)
+      blockFile->RestoreStats(sum, sumsq, clipped);
+   return blockFile;
 }
 
 /// Create a copy of this BlockFile, but using a different disk file.
@@ -531,6 +590,7 @@ BlockFile *SimpleBlockFile::Copy(wxFileName newFileName)
 {
    BlockFile *newBlockFile = new SimpleBlockFile(newFileName, mLen,
                                                  mMin, mMax, mRMS);
+   CopyStats(newBlockFile);
 
    return newBlockFile;
 }
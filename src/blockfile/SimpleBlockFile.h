@@ -63,6 +63,8 @@ class SimpleBlockFile : public BlockFile {
 
    /// Read the summary section of the disk file
    virtual bool ReadSummary(void *data);
+   /// Read only part of the summary section
+   virtual bool ReadSummaryPart(void *data, int offset, int bytes);
    /// Read the data section of the disk file
    virtual int ReadData(samplePtr data, sampleFormat format,
                         sampleCount start, sampleCount len);
@@ -270,9 +270,26 @@ bool EffectAutoDuck::Process()
       if (len > BUF_SIZE)
          len = BUF_SIZE;
 
-      mControlTrack->Get((samplePtr)buf, floatSample, pos, (sampleCount)len);
+      // If the peak of this stretch is too low to push the RMS window over
+      // the threshold, the window can only exceed it while it still holds
+      // samples from before the stretch.  So just the first RMS_WINDOW_SIZE
+      // samples need looking at; the summaries answer the peak query.
+      // (The range is widened a sample each side against rounding.)
+      sampleCount exactLen = len;
+      float quietMin, quietMax;
+      if (len > 2 * RMS_WINDOW_SIZE &&
+          mControlTrack->GetMinMax(&quietMin, &quietMax,
+                                   mControlTrack->LongSamplesToTime(pos - 1),
+                                   mControlTrack->LongSamplesToTime(pos + len + 1)))
+      {
+         float peak = wxMax(quietMax, -quietMin);
+         if (peak * peak * RMS_WINDOW_SIZE < threshold)
+            exactLen = RMS_WINDOW_SIZE;
+      }
+
+      mControlTrack->Get((samplePtr)buf, floatSample, pos, (sampleCount)exactLen);
 
-      for (i = pos; i < pos + len; i++)
+      for (i = pos; i < pos + exactLen; i++)
       {
          rmsSum -= rmsWindow[rmsPos];
          rmsWindow[rmsPos] = buf[i - pos] * buf[i - pos];
@@ -318,6 +335,44 @@ bool EffectAutoDuck::Process()
          }
       }
 
+      if (exactLen < len)
+      {
+         // The rest of the stretch is below the threshold throughout, which
+         // only counts towards the pause
+         sampleCount quietLen = len - exactLen;
+
+         if (inDuckRegion)
+         {
+            if (curSamplesPause + quietLen >= minSamplesPause)
+            {
+               i = pos + exactLen + (minSamplesPause - curSamplesPause) - 1;
+               curSamplesPause = minSamplesPause;
+
+               double duckRegionEnd =
+                  mControlTrack->LongSamplesToTime(i - curSamplesPause);
+
+               regions.Add(AutoDuckRegion(
+                              duckRegionStart - mOuterFadeDownLen,
+                              duckRegionEnd + mOuterFadeUpLen));
+
+               inDuckRegion = false;
+            }
+            else
+               curSamplesPause += quietLen;
+         }
+
+         // Leave the RMS window as it would be after the last sample
+         mControlTrack->Get((samplePtr)rmsWindow, floatSample,
+                            pos + len - RMS_WINDOW_SIZE, RMS_WINDOW_SIZE);
+         rmsSum = 0;
+         for (int j = 0; j < RMS_WINDOW_SIZE; j++)
+         {
+            rmsWindow[j] = rmsWindow[j] * rmsWindow[j];
+            rmsSum += rmsWindow[j];
+         }
+         rmsPos = 0;
+      }
+
       pos += len;
 
       if (TotalProgress( ((double)(pos-start)) / (end-start) /
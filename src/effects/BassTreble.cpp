@@ -37,11 +37,6 @@
 #include <wx/sizer.h>
 #include <wx/textctrl.h>
 
-// Used to communicate the type of the filter.
-static const int bassType = 0; //Low Shelf
-static const int trebleType = 1;  // High Shelf
-
-
 EffectBassTreble::EffectBassTreble()
 {
 }
@@ -144,55 +139,11 @@ bool EffectBassTreble::InitPass1()
 
 bool EffectBassTreble::NewTrackPass1()
 {
-   const float slope = 0.4f;   // same slope for both filters
-   const double hzBass = 250.0f;
-   const double hzTreble = 4000.0f;
-
-   //(re)initialise filter parameters
-   xn1Bass=xn2Bass=yn1Bass=yn2Bass=0;
-   xn1Treble=xn2Treble=yn1Treble=yn2Treble=0;
-
-   // Compute coefficents of the low shelf biquand IIR filter
-   Coefficents(hzBass, slope, dB_bass, bassType,
-               a0Bass, a1Bass, a2Bass,
-               b0Bass, b1Bass, b2Bass);
-
-   // Compute coefficents of the high shelf biquand IIR filter
-   Coefficents(hzTreble, slope, dB_treble, trebleType,
-               a0Treble, a1Treble, a2Treble,
-               b0Treble, b1Treble, b2Treble);
+   mFilter.Init(mCurRate, dB_bass, dB_treble);
 
    return true;
 }
 
-void EffectBassTreble::Coefficents(double hz, float slope, double gain, int type,
-                                   float& a0, float& a1, float& a2,
-                                   float& b0, float& b1, float& b2)
-{
-   double w = 2 * M_PI * hz / mCurRate;
-   double a = exp(log(10.0) * gain / 40);
-   double b = sqrt((a * a + 1) / slope - (pow((a - 1), 2)));
-
-   if (type == bassType)
-   {
-      b0 = a * ((a + 1) - (a - 1) * cos(w) + b * sin(w));
-      b1 = 2 * a * ((a - 1) - (a + 1) * cos(w));
-      b2 = a * ((a + 1) - (a - 1) * cos(w) - b * sin(w));
-      a0 = ((a + 1) + (a - 1) * cos(w) + b * sin(w));
-      a1 = -2 * ((a - 1) + (a + 1) * cos(w));
-      a2 = (a + 1) + (a - 1) * cos(w) - b * sin(w);
-   }
-   else //assumed trebleType
-   {
-      b0 = a * ((a + 1) + (a - 1) * cos(w) + b * sin(w));
-      b1 = -2 * a * ((a - 1) + (a + 1) * cos(w));
-      b2 = a * ((a + 1) + (a - 1) * cos(w) - b * sin(w));
-      a0 = ((a + 1) - (a - 1) * cos(w) + b * sin(w));
-      a1 = 2 * ((a - 1) - (a + 1) * cos(w));
-      a2 = (a + 1) - (a - 1) * cos(w) - b * sin(w);
-   }
-}
-
 bool EffectBassTreble::InitPass2()
 {
     return mbNormalize;
@@ -201,8 +152,14 @@ bool EffectBassTreble::InitPass2()
 // Process the input
 bool EffectBassTreble::ProcessPass1(float *buffer, sampleCount len)
 {
-   for (sampleCount i = 0; i < len; i++)
-      buffer[i] = (DoFilter(buffer[i]) / mPreGain);
+   mFilter.Process(buffer, len);
+
+   for (sampleCount i = 0; i < len; i++) {
+      // Retain the maximum value for use in the normalization pass
+      if (mMax < fabs(buffer[i]))
+         mMax = fabs(buffer[i]);
+      buffer[i] = buffer[i] / mPreGain;
+   }
 
    return true;
 }
@@ -219,31 +176,6 @@ bool EffectBassTreble::ProcessPass2(float *buffer, sampleCount len)
    return true;
 }
 
-float EffectBassTreble::DoFilter(float in)
-{
-   // Bass filter
-   float out = (b0Bass * in + b1Bass * xn1Bass + b2Bass * xn2Bass -
-         a1Bass * yn1Bass - a2Bass * yn2Bass) / a0Bass;
-   xn2Bass = xn1Bass;
-   xn1Bass = in;
-   yn2Bass = yn1Bass;
-   yn1Bass = out;
-
-   // Treble filter
-   in = out;
-   out = (b0Treble * in + b1Treble * xn1Treble + b2Treble * xn2Treble -
-         a1Treble * yn1Treble - a2Treble * yn2Treble) / a0Treble;
-   xn2Treble = xn1Treble;
-   xn1Treble = in;
-   yn2Treble = yn1Treble;
-   yn1Treble = out;
-
-   // Retain the maximum value for use in the normalization pass
-   if(mMax < fabs(out))
-      mMax = fabs(out);
-   return out;
-}
-
 //----------------------------------------------------------------------------
 // BassTrebleDialog
 //----------------------------------------------------------------------------
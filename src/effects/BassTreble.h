@@ -13,6 +13,7 @@
 #define __AUDACITY_EFFECT_BASS_TREBLE__
 
 #include "TwoPassSimpleMono.h"
+#include "BassTrebleFilter.h"
 
 class wxSizer;
 class wxTextCtrl;
@@ -53,22 +54,12 @@ protected:
    virtual bool ProcessPass1(float *buffer, sampleCount len);
    virtual bool ProcessPass2(float *buffer, sampleCount len);
 
-   void Coefficents(double hz, float slope, double gain, int type,
-                    float& a0, float& a1, float& a2, float& b0, float& b1, float& b2);
-
 private:
    virtual bool NewTrackPass1();
    virtual bool InitPass1();
    virtual bool InitPass2();
-   float  DoFilter(float in);
-
-   float xn1Bass, xn2Bass, yn1Bass, yn2Bass,
-         wBass, swBass, cwBass, aBass, bBass,
-         a0Bass, a1Bass, a2Bass, b0Bass, b1Bass, b2Bass;
-   // High shelf
-   float xn1Treble, xn2Treble, yn1Treble, yn2Treble,
-         wTreble, swTreble, cwTreble, aTreble, bTreble,
-         b0Treble, b1Treble, b2Treble, a0Treble, a1Treble, a2Treble;
+
+   BassTrebleFilter mFilter;
 
    double dB_bass, dB_treble, dB_level;
    double mMax;
@@ -0,0 +1,80 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BassTrebleFilter.cpp
+
+  Steve Daulton
+
+*******************************************************************//**
+
+\class BassTrebleFilter
+\brief The low shelf and high shelf biquads of EffectBassTreble.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include <math.h>
+
+#include "BassTrebleFilter.h"
+
+// Used to communicate the type of the filter.
+static const int bassType = 0; //Low Shelf
+static const int trebleType = 1;  // High Shelf
+
+void BassTrebleFilter::Init(double rate, double dBBass, double dBTreble)
+{
+   const float slope = 0.4f;   // same slope for both filters
+   const double hzBass = 250.0f;
+   const double hzTreble = 4000.0f;
+
+   float a0, a1, a2, b0, b1, b2;
+
+   //(re)initialise filter parameters
+   Biquad_Reset(&mBass);
+   Biquad_Reset(&mTreble);
+
+   // Compute coefficents of the low shelf biquand IIR filter
+   Coefficents(rate, hzBass, slope, dBBass, bassType,
+               a0, a1, a2, b0, b1, b2);
+   Biquad_SetCoeffs(&mBass, b0, b1, b2, a0, a1, a2);
+
+   // Compute coefficents of the high shelf biquand IIR filter
+   Coefficents(rate, hzTreble, slope, dBTreble, trebleType,
+               a0, a1, a2, b0, b1, b2);
+   Biquad_SetCoeffs(&mTreble, b0, b1, b2, a0, a1, a2);
+}
+
+void BassTrebleFilter::Process(float *buffer, sampleCount len)
+{
+   BiquadStruct *filters[2] = { &mBass, &mTreble };
+   Biquad_ProcessCascade(filters, 2, buffer, len);
+}
+
+void BassTrebleFilter::Coefficents(double rate, double hz, float slope, double gain, int type,
+                                   float& a0, float& a1, float& a2,
+                                   float& b0, float& b1, float& b2)
+{
+   double w = 2 * M_PI * hz / rate;
+   double a = exp(log(10.0) * gain / 40);
+   double b = sqrt((a * a + 1) / slope - (pow((a - 1), 2)));
+
+   if (type == bassType)
+   {
+      b0 = a * ((a + 1) - (a - 1) * cos(w) + b * sin(w));
+      b1 = 2 * a * ((a - 1) - (a + 1) * cos(w));
+      b2 = a * ((a + 1) - (a - 1) * cos(w) - b * sin(w));
+      a0 = ((a + 1) + (a - 1) * cos(w) + b * sin(w));
+      a1 = -2 * ((a - 1) + (a + 1) * cos(w));
+      a2 = (a + 1) + (a - 1) * cos(w) - b * sin(w);
+   }
+   else //assumed trebleType
+   {
+      b0 = a * ((a + 1) + (a - 1) * cos(w) + b * sin(w));
+      b1 = -2 * a * ((a - 1) + (a + 1) * cos(w));
+      b2 = a * ((a + 1) + (a - 1) * cos(w) - b * sin(w));
+      a0 = ((a + 1) - (a - 1) * cos(w) + b * sin(w));
+      a1 = 2 * ((a - 1) - (a + 1) * cos(w));
+      a2 = (a + 1) - (a - 1) * cos(w) - b * sin(w);
+   }
+}
@@ -0,0 +1,40 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  BassTrebleFilter.h
+
+  Steve Daulton
+
+  The low and high shelf filters behind Bass and Treble, kept apart from
+  the effect so that they can be tested on their own.
+
+**********************************************************************/
+
+#ifndef __AUDACITY_BASS_TREBLE_FILTER__
+#define __AUDACITY_BASS_TREBLE_FILTER__
+
+#include "../Audacity.h"
+#include "../Sequence.h"
+#include "Biquad.h"
+
+class BassTrebleFilter
+{
+ public:
+   /// Sets up shelves of dBBass below 250 Hz and dBTreble above 4 kHz for
+   /// a track at the given rate, and clears the filters' history.
+   void Init(double rate, double dBBass, double dBTreble);
+
+   /// Filters buffer in place, carrying the filters' state on to the next
+   /// call.
+   void Process(float *buffer, sampleCount len);
+
+ private:
+   void Coefficents(double rate, double hz, float slope, double gain, int type,
+                    float& a0, float& a1, float& a2, float& b0, float& b1, float& b2);
+
+   // Low shelf followed by high shelf, run as one cascade
+   BiquadStruct mBass, mTreble;
+};
+
+#endif
@@ -1,6 +1,9 @@
 #include "Biquad.h"
 
+#include <string.h>
+
 #define square(a) ((a)*(a))
+#define MAX_CASCADE 8
 
 void Biquad_Process (BiquadStruct* pBQ, int iNumSamples)
 {
@@ -29,6 +32,74 @@ void Biquad_Process (BiquadStruct* pBQ, int iNumSamples)
    pBQ->fPrevPrevOut = fPrevPrevOut;
 }
 
+void Biquad_ProcessCascade (BiquadStruct** ppBQ, int iNumStages, float* pfBuf, int iNumSamples)
+{
+   // Carrying each sample through every section, rather than running each
+   // section over the whole buffer, lets the recurrences of successive
+   // sections overlap in the pipeline and touches the buffer only once.
+   // The arithmetic per section is unchanged, so results are identical.
+   while (iNumStages > MAX_CASCADE)
+   {
+      Biquad_ProcessCascade (ppBQ, MAX_CASCADE, pfBuf, iNumSamples);
+      ppBQ += MAX_CASCADE;
+      iNumStages -= MAX_CASCADE;
+   }
+
+   float fCoeffs [MAX_CASCADE][5];
+   float fState [MAX_CASCADE][4];	// PrevIn, PrevPrevIn, PrevOut, PrevPrevOut
+   int j;
+   for (j = 0; j < iNumStages; j++)
+   {
+      memcpy (fCoeffs [j], ppBQ [j]->fNumerCoeffs, sizeof (ppBQ [j]->fNumerCoeffs));
+      memcpy (fCoeffs [j] + 3, ppBQ [j]->fDenomCoeffs, sizeof (ppBQ [j]->fDenomCoeffs));
+      fState [j][0] = ppBQ [j]->fPrevIn;
+      fState [j][1] = ppBQ [j]->fPrevPrevIn;
+      fState [j][2] = ppBQ [j]->fPrevOut;
+      fState [j][3] = ppBQ [j]->fPrevPrevOut;
+   }
+   for (int i = 0; i < iNumSamples; i++)
+   {
+      float fIn = pfBuf [i];
+      for (j = 0; j < iNumStages; j++)
+      {
+         const float* pfC = fCoeffs [j];
+         float* pfS = fState [j];
+         float fOut = fIn * pfC [0] +
+            pfS [0] * pfC [1] +
+            pfS [1] * pfC [2] -
+            pfS [2] * pfC [3] -
+            pfS [3] * pfC [4];
+         pfS [1] = pfS [0];
+         pfS [0] = fIn;
+         pfS [3] = pfS [2];
+         pfS [2] = fOut;
+         fIn = fOut;
+      }
+      pfBuf [i] = fIn;
+   }
+   for (j = 0; j < iNumStages; j++)
+   {
+      ppBQ [j]->fPrevIn = fState [j][0];
+      ppBQ [j]->fPrevPrevIn = fState [j][1];
+      ppBQ [j]->fPrevOut = fState [j][2];
+      ppBQ [j]->fPrevPrevOut = fState [j][3];
+   }
+}
+
+void Biquad_SetCoeffs (BiquadStruct* pBQ, float fB0, float fB1, float fB2, float fA0, float fA1, float fA2)
+{
+   pBQ->fNumerCoeffs [0] = fB0 / fA0;
+   pBQ->fNumerCoeffs [1] = fB1 / fA0;
+   pBQ->fNumerCoeffs [2] = fB2 / fA0;
+   pBQ->fDenomCoeffs [0] = fA1 / fA0;
+   pBQ->fDenomCoeffs [1] = fA2 / fA0;
+}
+
+void Biquad_Reset (BiquadStruct* pBQ)
+{
+   pBQ->fPrevIn = pBQ->fPrevPrevIn = pBQ->fPrevOut = pBQ->fPrevPrevOut = 0;
+}
+
 void ComplexDiv (float fNumerR, float fNumerI, float fDenomR, float fDenomI, float* pfQuotientR, float* pfQuotientI)
 {
    float fDenom = square(fDenomR) + square(fDenomI);
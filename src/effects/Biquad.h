@@ -11,6 +11,12 @@ typedef struct {
    float fPrevPrevOut;
 } BiquadStruct;
 void Biquad_Process (BiquadStruct* pBQ, int iNumSamples);
+// Runs iNumStages sections in series over pfBuf in place, one sample at a time
+// through the whole cascade.  The sections' pfIn/pfOut are ignored.
+void Biquad_ProcessCascade (BiquadStruct** ppBQ, int iNumStages, float* pfBuf, int iNumSamples);
+// Loads raw coefficients, dividing through by fA0 so that the recurrence needs no division
+void Biquad_SetCoeffs (BiquadStruct* pBQ, float fB0, float fB1, float fB2, float fA0, float fA1, float fA2);
+void Biquad_Reset (BiquadStruct* pBQ);
 void ComplexDiv (float fNumerR, float fNumerI, float fDenomR, float fDenomI, float* pfQuotientR, float* pfQuotientI);
 bool BilinTransform (float fSX, float fSY, float* pfZX, float* pfZY);
 float Calc2D_DistSqr (float fX1, float fY1, float fX2, float fY2);
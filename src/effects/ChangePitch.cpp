@@ -153,11 +153,17 @@ bool EffectChangePitch::TransferParameters( Shuttle & shuttle )
    return true;
 }
 
+SoundTouch *EffectChangePitch::NewSoundTouch()
+{
+   SoundTouch *soundTouch = new SoundTouch();
+   soundTouch->setPitchSemiTones((float)(m_dSemitonesChange));
+   return soundTouch;
+}
+
 bool EffectChangePitch::Process()
 {
-   mSoundTouch = new SoundTouch();
+   mSoundTouch = NewSoundTouch();
    SetTimeWarper(new IdentityTimeWarper());
-   mSoundTouch->setPitchSemiTones((float)(m_dSemitonesChange));
 #ifdef USE_MIDI
    // Note: m_dSemitonesChange is private to ChangePitch because it only
    // needs to pass it along to mSoundTouch (above). I added mSemitones
@@ -64,6 +64,9 @@ class EffectChangePitch : public EffectSoundTouch
    virtual bool CheckWhetherSkipEffect() { return (m_dPercentChange == 0.0); }
    virtual bool Process();
 
+protected:
+   virtual SoundTouch *NewSoundTouch();
+
 private:
    double m_dSemitonesChange;   // how many semitones to change pitch
    double m_dStartFrequency;    // starting frequency of first 0.2s of selection
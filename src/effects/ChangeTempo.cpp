@@ -106,10 +106,16 @@ bool EffectChangeTempo::TransferParameters( Shuttle & shuttle )
    return true;
 }
 
+SoundTouch *EffectChangeTempo::NewSoundTouch()
+{
+   SoundTouch *soundTouch = new SoundTouch();
+   soundTouch->setTempoChange(m_PercentChange);
+   return soundTouch;
+}
+
 bool EffectChangeTempo::Process()
 {
-   mSoundTouch = new SoundTouch();
-   mSoundTouch->setTempoChange(m_PercentChange);
+   mSoundTouch = NewSoundTouch();
    double mT1Dashed = mT0 + (mT1 - mT0)/(m_PercentChange/100.0 + 1.0);
    SetTimeWarper(new RegionTimeWarper(mT0, mT1,
             new LinearTimeWarper(mT0, mT0, mT1, mT1Dashed )));
@@ -62,6 +62,9 @@ class EffectChangeTempo : public EffectSoundTouch {
 
    double CalcPreviewInputLength(double previewLength);
 
+ protected:
+   virtual SoundTouch *NewSoundTouch();
+
  private:
    double         m_PercentChange;  // percent change to apply to tempo
                                     // -100% is meaningless, but sky's the upper limit
@@ -48,6 +48,7 @@
 #include <wx/intl.h>
 
 #include "ClickRemoval.h"
+#include "ClickRemover.h"
 #include "../ShuttleGui.h"
 #include "../Envelope.h"
 // #include "../FFT.h"
@@ -179,6 +180,7 @@ bool EffectClickRemoval::ProcessOne(int count, WaveTrack * track, sampleCount st
    sampleCount s = 0;
    float *buffer = new float[idealBlockLen];
    float *datawindow = new float[windowSize];
+   ClickRemover remover(windowSize, sep, mThresholdLevel, mClickWidth);
    while ((s < len)  &&  ((len - s) > windowSize/2))
    {
       sampleCount block = idealBlockLen;
@@ -199,7 +201,7 @@ bool EffectClickRemoval::ProcessOne(int count, WaveTrack * track, sampleCount st
          for(j=wcopy; j<windowSize; j++)
             datawindow[j] = 0;
 
-         mbDidSomething |= RemoveClicks(windowSize, datawindow);
+         mbDidSomething |= remover.RemoveClicks(windowSize, datawindow);
 
          for(j=0; j<wcopy; j++)
            buffer[i+j] = datawindow[j];
@@ -222,79 +224,6 @@ bool EffectClickRemoval::ProcessOne(int count, WaveTrack * track, sampleCount st
    return bResult;
 }
 
-bool EffectClickRemoval::RemoveClicks(sampleCount len, float *buffer)
-{
-   bool bResult = false; // This effect usually does nothing.
-   int i;
-   int j;
-   int left = 0;
-
-   float msw;
-   int ww;
-   int s2 = sep/2;
-   float *ms_seq = new float[len];
-   float *b2 = new float[len];
-
-   for( i=0; i<len; i++)
-      b2[i] = buffer[i]*buffer[i];
-
-   /* Shortcut for rms - multiple passes through b2, accumulating
-    * as we go.
-    */
-   for(i=0;i<len;i++)
-      ms_seq[i]=b2[i];
-
-   for(i=1; i < sep; i *= 2) {
-      for(j=0;j<len-i; j++)
-         ms_seq[j] += ms_seq[j+i];
-      }
-
-      /* Cheat by truncating sep to next-lower power of two... */
-      sep = i;
-
-      for( i=0; i<len-sep; i++ ) {
-         ms_seq[i] /= sep;
-      }
-      /* ww runs from about 4 to mClickWidth.  wrc is the reciprocal;
-       * chosen so that integer roundoff doesn't clobber us.
-       */
-      int wrc;
-      for(wrc=mClickWidth/4; wrc>=1; wrc /= 2) {
-         ww = mClickWidth/wrc;
-
-         for( i=0; i<len-sep; i++ ){
-            msw = 0;
-            for( j=0; j<ww; j++) {
-               msw += b2[i+s2+j];
-            }
-            msw /= ww;
-
-            if(msw >= mThresholdLevel * ms_seq[i]/10) {
-               if( left == 0 ) {
-                  left = i+s2;
-               }
-            } else {
-               if(left != 0 && i-left+s2 <= ww*2) {
-                  float lv = buffer[left];
-                  float rv = buffer[i+ww+s2];
-                  for(j=left; j<i+ww+s2; j++) {
-                     bResult = true;
-                     buffer[j]= (rv*(j-left) + lv*(i+ww+s2-j))/(float)(i+ww+s2-left);
-                     b2[j] = buffer[j]*buffer[j];
-                  }
-                  left=0;
-               } else if(left != 0) {
-               left = 0;
-            }
-         }
-      }
-   }
-   delete[] ms_seq;
-   delete[] b2;
-   return bResult;
-}
-
-
 // WDR: class implementations
 
 //----------------------------------------------------------------------------
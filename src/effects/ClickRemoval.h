@@ -69,8 +69,6 @@ private:
    bool ProcessOne(int count, WaveTrack * track,
                    sampleCount start, sampleCount len);
 
-   bool RemoveClicks(sampleCount len, float *buffer);
-
    Envelope *mEnvelope;
 
    bool mbDidSomething; // This effect usually does nothing on real-world data.
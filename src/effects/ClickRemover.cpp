@@ -0,0 +1,123 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ClickRemover.cpp
+
+  Craig DeForest
+
+*******************************************************************//**
+
+\class ClickRemover
+\brief Finds and repairs clicks in a window of samples, for
+EffectClickRemoval.
+
+  Clicks are identified as small regions of high amplitude compared
+  to the surrounding chunk of sound.  Anything sufficiently tall compared
+  to a large (2048 sample) window around it, and sufficiently narrow,
+  is considered to be a click.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+
+#include "ClickRemover.h"
+
+ClickRemover::ClickRemover(int windowSize, int sep, int thresholdLevel,
+                           int clickWidth)
+{
+   mSep = sep;
+   mThresholdLevel = thresholdLevel;
+   mClickWidth = clickWidth;
+
+   mSquares = new float[windowSize];
+   mMeanSquares = new float[windowSize];
+}
+
+ClickRemover::~ClickRemover()
+{
+   delete[] mSquares;
+   delete[] mMeanSquares;
+}
+
+bool ClickRemover::RemoveClicks(sampleCount len, float *buffer)
+{
+   bool bResult = false; // This effect usually does nothing.
+   int i;
+   int j;
+   int left = 0;
+
+   float msw;
+   int ww;
+   int s2 = mSep/2;
+   float *ms_seq = mMeanSquares;
+   float *b2 = mSquares;
+
+   mClicks.clear();
+
+   for( i=0; i<len; i++)
+      b2[i] = buffer[i]*buffer[i];
+
+   /* Shortcut for rms - multiple passes through b2, accumulating
+    * as we go.
+    */
+   for(i=0;i<len;i++)
+      ms_seq[i]=b2[i];
+
+   for(i=1; i < mSep; i *= 2) {
+      for(j=0;j<len-i; j++)
+         ms_seq[j] += ms_seq[j+i];
+      }
+
+      /* Cheat by truncating sep to next-lower power of two... */
+      mSep = i;
+
+      for( i=0; i<len-mSep; i++ ) {
+         ms_seq[i] /= mSep;
+      }
+      /* ww runs from about 4 to mClickWidth.  wrc is the reciprocal;
+       * chosen so that integer roundoff doesn't clobber us.
+       */
+      int wrc;
+      for(wrc=mClickWidth/4; wrc>=1; wrc /= 2) {
+         ww = mClickWidth/wrc;
+
+         /* Sum of b2 over the ww samples from i+s2, slid along with i
+          * instead of being added up again at every step.
+          */
+         double sum = 0;
+         for( j=0; j<ww; j++)
+            sum += b2[s2+j];
+
+         for( i=0; i<len-mSep; i++ ){
+            msw = sum / ww;
+
+            if(msw >= mThresholdLevel * ms_seq[i]/10) {
+               if( left == 0 ) {
+                  left = i+s2;
+               }
+            } else {
+               if(left != 0 && i-left+s2 <= ww*2) {
+                  float lv = buffer[left];
+                  float rv = buffer[i+ww+s2];
+                  for(j=left; j<i+ww+s2; j++) {
+                     bResult = true;
+                     buffer[j]= (rv*(j-left) + lv*(i+ww+s2-j))/(float)(i+ww+s2-left);
+                     float old = b2[j];
+                     b2[j] = buffer[j]*buffer[j];
+                     if (j >= i+s2)
+                        sum += b2[j] - old;
+                  }
+                  mClicks.push_back(left);
+                  mClicks.push_back(i+ww+s2);
+                  left=0;
+               } else if(left != 0) {
+               left = 0;
+            }
+         }
+            if (i+1 < len-mSep)
+               sum += b2[i+s2+ww] - b2[i+s2];
+      }
+   }
+   return bResult;
+}
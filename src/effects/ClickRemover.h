@@ -0,0 +1,51 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ClickRemover.h
+
+  Craig DeForest
+
+  The click detector and repair behind Click Removal, kept apart from the
+  effect so that it can be tested on its own.
+
+**********************************************************************/
+
+#ifndef __AUDACITY_CLICK_REMOVER__
+#define __AUDACITY_CLICK_REMOVER__
+
+#include <vector>
+
+#include "../Audacity.h"
+#include "../Sequence.h"
+
+class ClickRemover
+{
+ public:
+   /// windowSize is the most samples RemoveClicks() will be given.  A
+   /// click is a run of samples, narrower than about clickWidth, whose
+   /// power is at least thresholdLevel/10 times that of the sep samples
+   /// around it.
+   ClickRemover(int windowSize, int sep, int thresholdLevel, int clickWidth);
+   ~ClickRemover();
+
+   /// Repairs the clicks found in buffer by interpolating across them.
+   /// Returns true if there were any.
+   bool RemoveClicks(sampleCount len, float *buffer);
+
+   /// The samples the last RemoveClicks() rewrote, as [start, end) pairs
+   /// in the order they were repaired
+   const std::vector<sampleCount> &GetClicks() const { return mClicks; }
+
+ private:
+   int mSep;
+   int mThresholdLevel;
+   int mClickWidth;
+
+   float *mSquares;     // scratch, windowSize long
+   float *mMeanSquares;
+
+   std::vector<sampleCount> mClicks;
+};
+
+#endif
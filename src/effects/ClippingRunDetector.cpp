@@ -0,0 +1,96 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ClippingRunDetector.cpp
+
+*******************************************************************//**
+
+\class ClippingRunDetector
+\brief Finds the runs of clipped samples that Find Clipping labels
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+
+#include "ClippingRunDetector.h"
+
+ClippingRunDetector::ClippingRunDetector(int start, int stop)
+:  mStart(start),
+   mStop(stop),
+   mStartRun(0),
+   mStopRun(0),
+   mSamps(0),
+   mRunStart(0),
+   mRunEnd(0),
+   mRunClipped(0),
+   mRunSamples(0)
+{
+}
+
+bool ClippingRunDetector::Sample(bool clipped, sampleCount s)
+{
+   if (clipped) {
+      if (mStartRun == 0) {
+         mRunStart = s;
+         mSamps = 0;
+      }
+      else {
+         mStopRun = 0;
+      }
+      mStartRun++;
+      mSamps++;
+   }
+   else {
+      if (mStartRun >= mStart) {
+         mStopRun++;
+         mSamps++;
+
+         if (mStopRun >= mStop) {
+            mRunEnd = s - mStop;
+            mRunClipped = mStartRun;
+            mRunSamples = mSamps - mStop;
+            mStartRun = 0;
+            mStopRun = 0;
+            mSamps = 0;
+            return true;
+         }
+      }
+      else {
+         mStartRun = 0;
+      }
+   }
+
+   return false;
+}
+
+bool ClippingRunDetector::SkipUnclipped(sampleCount s, sampleCount len)
+{
+   if (len <= 0)
+      return false;
+
+   if (mStartRun < mStart) {
+      mStartRun = 0;
+      return false;
+   }
+
+   // A run is open; it ends at the (mStop - mStopRun)th of these samples
+   sampleCount need = mStop - mStopRun;
+   if (need < 1)
+      need = 1;
+
+   if (len < need) {
+      mStopRun += len;
+      mSamps += len;
+      return false;
+   }
+
+   mSamps += need;
+   mRunEnd = s + need - 1 - mStop;
+   mRunClipped = mStartRun;
+   mRunSamples = mSamps - mStop;
+   mStartRun = 0;
+   mStopRun = 0;
+   mSamps = 0;
+   return true;
+}
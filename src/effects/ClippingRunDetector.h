@@ -0,0 +1,51 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  ClippingRunDetector.h
+
+**********************************************************************/
+
+#ifndef __AUDACITY_CLIPPING_RUN_DETECTOR__
+#define __AUDACITY_CLIPPING_RUN_DETECTOR__
+
+#include "../Audacity.h"
+#include "../Sequence.h"
+
+/// The run counting behind Find Clipping: a run starts after mStart
+/// clipped samples in a row and ends after mStop unclipped ones.  Kept
+/// apart from the effect so that skipping spans known to be unclipped
+/// can be checked against feeding every sample.
+class ClippingRunDetector
+{
+ public:
+   ClippingRunDetector(int start, int stop);
+
+   /// Feeds sample number s.  Returns true if that ended a run.
+   bool Sample(bool clipped, sampleCount s);
+   /// Feeds len unclipped samples starting at number s, as if each had
+   /// been passed to Sample().  Returns true if they ended a run.
+   bool SkipUnclipped(sampleCount s, sampleCount len);
+
+   /// The run that just ended: its first sample, the sample its label
+   /// ends at, and the label's "n of m" counts
+   sampleCount GetRunStart() const { return mRunStart; }
+   sampleCount GetRunEnd() const { return mRunEnd; }
+   sampleCount GetRunClipped() const { return mRunClipped; }
+   sampleCount GetRunSamples() const { return mRunSamples; }
+
+ private:
+   int mStart;
+   int mStop;
+
+   sampleCount mStartRun;
+   sampleCount mStopRun;
+   sampleCount mSamps;
+
+   sampleCount mRunStart;
+   sampleCount mRunEnd;
+   sampleCount mRunClipped;
+   sampleCount mRunSamples;
+};
+
+#endif
@@ -226,8 +226,18 @@ bool EffectDtmf::MakeDtmfTone(float *buffer, sampleCount len, float fs, wxChar t
 
    // now generate the wave: 'last' is used to avoid phase errors
    // when inside the inner for loop of the Process() function.
+   // Each tone is a unit phasor rotated once per sample, started from the
+   // exact phase at 'last', so only the set-up needs sin() and cos().
+   double reA = cos(A*last), imA = sin(A*last), cA = cos(A), sA = sin(A);
+   double reB = cos(B*last), imB = sin(B*last), cB = cos(B), sB = sin(B);
    for(sampleCount i=0; i<len; i++) {
-      buffer[i]=amplitude*0.5*(sin(A*(i+last))+sin(B*(i+last)));
+      buffer[i]=amplitude*0.5*(imA+imB);
+      double t = reA*cA - imA*sA;
+      imA = reA*sA + imA*cA;
+      reA = t;
+      t = reB*cB - imB*sB;
+      imB = reB*sB + imB*cB;
+      reB = t;
    }
 
    // generate a fade-in of duration 1/250th of second
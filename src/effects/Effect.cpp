@@ -1559,7 +1559,11 @@ bool Effect::RealtimeInitialize()
 #if defined(EXPERIMENTAL_REALTIME_EFFECTS)
    if (mClient)
    {
-      mBlockSize = mClient->GetBlockSize(512);
+      // RealtimeProcess() gets whole device buffers, which are often
+      // larger than 512 samples, so offer the client large runs and let it
+      // settle on what it prefers.  Fewer runs per buffer means less
+      // per-call overhead in the plugin.
+      mBlockSize = mClient->GetBlockSize(REALTIME_MAX_BLOCK_SIZE);
       return mClient->RealtimeInitialize();
    }
 #endif
@@ -1780,22 +1784,10 @@ sampleCount Effect::RealtimeProcess(int group,
       }
 
       // Finally call the plugin to process the block
-      len = 0;
-      for (sampleCount block = 0; block < numSamples; block += mBlockSize)
-      {
-         sampleCount cnt = (block + mBlockSize > numSamples ? numSamples - block : mBlockSize);
-         len += mClient->RealtimeProcess(processor, clientIn, clientOut, cnt);
-
-         for (int i = 0 ; i < mNumAudioIn; i++)
-         {
-            clientIn[i] += cnt;
-         }
-
-         for (int i = 0 ; i < mNumAudioOut; i++)
-         {
-            clientOut[i] += cnt;
-         }
-      }
+      len = RealtimeProcessRuns(mClient, processor,
+                                clientIn, mNumAudioIn,
+                                clientOut, mNumAudioOut,
+                                numSamples, mBlockSize);
 
       // Bump to next processor
       processor++;
@@ -1812,6 +1804,12 @@ bool Effect::RealtimeProcessEnd()
    return mClient->RealtimeProcessEnd();
 }
 
+// The delay the client has added to its output since last asked
+sampleCount Effect::RealtimeGetLatency()
+{
+   return mClient->GetLatency();
+}
+
 bool Effect::IsRealtimeActive()
 {
    return mRealtimeSuspendCount == 0;
@@ -33,6 +33,7 @@ class wxWindow;
 #include "../ShuttleGui.h"
 #include "../Internat.h"
 #include "../widgets/ProgressDialog.h"
+#include "RealtimeRuns.h"
 
 class SelectedRegion;
 class TimeWarper;
@@ -283,6 +284,7 @@ class AUDACITY_DLL_API Effect : public EffectHostInterface
                                float **outbuf,
                                sampleCount numSamples);
    bool RealtimeProcessEnd();
+   sampleCount RealtimeGetLatency();
    bool IsRealtimeActive();
 
  //
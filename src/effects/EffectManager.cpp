@@ -770,6 +770,36 @@ int EffectManager::GetRealtimeLatency()
    return mRealtimeLatency;
 }
 
+//
+// This will be called in a different thread than the main GUI thread.
+//
+// Returns how many samples the active effects have delayed their output
+// by since the last call.  Unlike GetRealtimeLatency(), which is the time
+// spent processing, this is part of the audio and has to be compensated.
+//
+sampleCount EffectManager::GetRealtimeDelay()
+{
+   sampleCount delay = 0;
+
+   // Protect ourselves from the main thread
+   mRealtimeLock.Enter();
+
+   if (!mRealtimeSuspended)
+   {
+      for (size_t i = 0, cnt = mRealtimeEffects.GetCount(); i < cnt; i++)
+      {
+         if (mRealtimeEffects[i]->IsRealtimeActive())
+         {
+            delay += mRealtimeEffects[i]->RealtimeGetLatency();
+         }
+      }
+   }
+
+   mRealtimeLock.Leave();
+
+   return delay;
+}
+
 Effect *EffectManager::GetEffect(const PluginID & ID)
 {
    Effect *effect;
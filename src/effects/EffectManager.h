@@ -111,6 +111,7 @@ class AUDACITY_DLL_API EffectManager
    sampleCount RealtimeProcess(int group, int chans, float **buffers, sampleCount numSamples);
    void RealtimeProcessEnd();
    int GetRealtimeLatency();
+   sampleCount GetRealtimeDelay();
 #endif
 
 #if defined(EXPERIMENTAL_EFFECTS_RACK)
@@ -144,11 +144,14 @@ bool EffectFindClipping::ProcessOne(LabelTrack * l,
 
    float *ptr = buffer;
 
-   sampleCount startrun = 0;
-   sampleCount stoprun = 0;
-   sampleCount samps = 0;
+   ClippingRunDetector detector(mStart, mStop);
    sampleCount block = 0;
-   double startTime = -1.0;
+
+   // Block summaries let us skip any span whose peak is below the clipping
+   // level without reading it, but only once on-demand summaries are done.
+   bool useSummaries = (t->GetODFlags() == 0);
+   sampleCount summarySpan = t->GetMaxBlockSize();
+   sampleCount scanTo = 0;
 
    while (s < len) {
       if (block == 0) {
@@ -157,6 +160,28 @@ bool EffectFindClipping::ProcessOne(LabelTrack * l,
             break;
          }
 
+         if (useSummaries && s >= scanTo) {
+            sampleCount span = s + summarySpan > len ? len - s : summarySpan;
+            float min, max;
+
+            // Widen the query by a sample on each side so that rounding
+            // between samples and time can never hide a clipped sample.
+            t->GetMinMax(&min, &max,
+                         t->LongSamplesToTime(start + s - 1),
+                         t->LongSamplesToTime(start + s + span + 1));
+
+            if (max < MAX_AUDIO && min > -MAX_AUDIO) {
+               // Nothing in this span is clipped
+               if (detector.SkipUnclipped(s, span))
+                  AddClippingLabel(l, t, start, detector);
+
+               s += span;
+               continue;
+            }
+
+            scanTo = s + span;
+         }
+
          block = s + blockSize > len ? len - s : blockSize;
 
          t->Get((samplePtr)buffer, floatSample, start + s, block);
@@ -164,35 +189,8 @@ bool EffectFindClipping::ProcessOne(LabelTrack * l,
       }
 
       float v = fabs(*ptr++);
-      if (v >= MAX_AUDIO) {
-         if (startrun == 0) {
-            startTime = t->LongSamplesToTime(start + s);
-            samps = 0;
-         }
-         else {
-            stoprun = 0;
-         }
-         startrun++;
-         samps++;
-      }
-      else {
-         if (startrun >= mStart) {
-            stoprun++;
-            samps++;
-
-            if (stoprun >= mStop) {
-               l->AddLabel(SelectedRegion(startTime,
-                                          t->LongSamplesToTime(start + s - mStop)),
-                           wxString::Format(wxT("%lld of %lld"), (long long) startrun, (long long) (samps - mStop)));
-               startrun = 0;
-               stoprun = 0;
-               samps = 0;
-            }
-         }
-         else {
-            startrun = 0;
-         }
-      }
+      if (detector.Sample(v >= MAX_AUDIO, s))
+         AddClippingLabel(l, t, start, detector);
 
       s++;
       block--;
@@ -203,6 +201,17 @@ bool EffectFindClipping::ProcessOne(LabelTrack * l,
    return bGoodResult;
 }
 
+void EffectFindClipping::AddClippingLabel(LabelTrack *l, WaveTrack *t,
+                                          sampleCount start,
+                                          const ClippingRunDetector &detector)
+{
+   l->AddLabel(SelectedRegion(t->LongSamplesToTime(start + detector.GetRunStart()),
+                              t->LongSamplesToTime(start + detector.GetRunEnd())),
+               wxString::Format(wxT("%lld of %lld"),
+                                (long long) detector.GetRunClipped(),
+                                (long long) detector.GetRunSamples()));
+}
+
 //----------------------------------------------------------------------------
 // FindClippingDialog
 //----------------------------------------------------------------------------
@@ -19,6 +19,7 @@ class wxString;
 #include <wx/intl.h>
 
 #include "Effect.h"
+#include "ClippingRunDetector.h"
 
 class wxStaticText;
 
@@ -64,6 +65,8 @@ class EffectFindClipping:public Effect
  private:
    bool ProcessOne(LabelTrack *l, int count, WaveTrack * t,
                    sampleCount start, sampleCount len);
+   void AddClippingLabel(LabelTrack *l, WaveTrack *t, sampleCount start,
+                         const ClippingRunDetector &detector);
 
    int mStart;   ///< Using int rather than sampleCount because values are only ever small numbers
    int mStop;    ///< Using int rather than sampleCount because values are only ever small numbers
@@ -33,9 +33,24 @@
 // EffectNoise
 //
 
+// A 32-bit xorshift generator.  rand() costs a library call (and often a
+// lock) per sample, which dominated generating long stretches of noise.
+static inline unsigned int NextRandom(unsigned int &state)
+{
+   state ^= state << 13;
+   state ^= state >> 17;
+   state ^= state << 5;
+   return state;
+}
+
 bool EffectNoise::Init()
 {
    gPrefs->Read(wxT("/Effects/Noise/Duration"), &mDuration, 1L);
+
+   // Still seeded from rand(), so each run gives different noise
+   mRandState = ((unsigned int)rand() << 16) ^ (unsigned int)rand();
+   if (mRandState == 0)
+      mRandState = 1;
    return true;
 }
 
@@ -99,13 +114,15 @@ bool EffectNoise::MakeNoise(float *buffer, sampleCount len, float fs, float ampl
 {
    float white;
    sampleCount i;
-   float div = ((float)RAND_MAX) / 2.0f;
+   // maps the full unsigned range onto [-1, 1)
+   const float scale = 2.0f / 4294967296.0f;
+   unsigned int seed = mRandState;
 
    switch (noiseType) {
    default:
    case 0: // white
        for(i=0; i<len; i++)
-          buffer[i] = amplitude * ((rand() / div) - 1.0f);
+          buffer[i] = amplitude * ((NextRandom(seed) * scale) - 1.0f);
        break;
 
    case 1: // pink
@@ -115,7 +132,7 @@ bool EffectNoise::MakeNoise(float *buffer, sampleCount len, float fs, float ampl
       // 0.129f is an experimental normalization factor.
       amplitude *= 0.129f;
       for(i=0; i<len; i++) {
-      white=(rand() / div) - 1.0f;
+      white=(NextRandom(seed) * scale) - 1.0f;
       buf0=0.99886f * buf0 + 0.0555179f * white;
       buf1=0.99332f * buf1 + 0.0750759f * white;
       buf2=0.96900f * buf2 + 0.1538520f * white;
@@ -137,13 +154,14 @@ bool EffectNoise::MakeNoise(float *buffer, sampleCount len, float fs, float ampl
        float scaling = (9.0/sqrt(fs) > 0.01)? 9.0/sqrt(fs) : 0.01;
 
        for(i=0; i<len; i++){
-         white=(rand() / div) - 1.0f;
+         white=(NextRandom(seed) * scale) - 1.0f;
          z = leakage * y + white * scaling;
          y = (fabs(z) > 1.0) ? (leakage * y - white * scaling) : z;
          buffer[i] = amplitude * y;
        }
        break;
    }
+   mRandState = seed;
    return true;
 }
 
@@ -37,6 +37,7 @@ class EffectNoise : public BlockGenerator {
       noiseType = 0;
       noiseAmplitude = 1.0;
       y = z = buf0 = buf1 = buf2 = buf3 = buf4 = buf5 = buf6 = 0;
+      mRandState = 1;
    }
    virtual bool Init();
 
@@ -78,6 +79,7 @@ class EffectNoise : public BlockGenerator {
    int noiseType;
    double noiseAmplitude;
    float y, z, buf0, buf1, buf2, buf3, buf4, buf5, buf6;
+   unsigned int mRandState;   // xorshift state, never zero
 
  protected:
    virtual bool MakeNoise(float *buffer, sampleCount len, float fs, float amplitude);
@@ -28,6 +28,7 @@
 #include "../ShuttleGui.h"
 #include "../Internat.h"
 #include "../WaveTrack.h"
+#include "../BlockFile.h"
 #include "../Prefs.h"
 #include "../Project.h"
 #include "../Shuttle.h"
@@ -304,6 +305,16 @@ bool EffectNormalize::AnalyseDC(WaveTrack * track, wxString msg)
    sampleCount start = track->TimeToLongSamples(mCurT0);
    sampleCount end = track->TimeToLongSamples(mCurT1);
 
+   // The sequence keeps exact per-block sums, so only the partial blocks
+   // at the ends of the selection need reading.  Gaps between clips
+   // count as zeros, as in the scan below, which is still used if some
+   // of the audio is being loaded on demand.
+   SampleStats stats;
+   if (end > start && track->GetStatistics(&stats, start, end - start)) {
+      mOffset = (float)(-stats.GetMean());
+      return rc;
+   }
+
    //Get the length of the buffer (as double). len is
    //used simply to calculate a progress meter, so it is easier
    //to make it a double now than it is to do it later
@@ -39,10 +39,12 @@ Some GUI code was taken from the Echo effect
 #include <wx/intl.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include "Paulstretch.h"
 #include "../WaveTrack.h"
 #include "../FFT.h"
+#include "../RealFFTf.h"
 
 
 EffectPaulstretch::EffectPaulstretch(){
@@ -136,7 +138,9 @@ class PaulStretch{
       float rap;
       float *old_out_smp_buf;
 
-      float *fft_smps,*fft_c,*fft_s,*fft_freq,*fft_tmp;
+      HFFT hFFT;//shared tables for FFTs of poolsize, kept for the whole run
+      float *fft_window;//the analysis window, computed once
+      float *fft_smps,*fft_buf,*fft_freq;
 
       double remained_samples;//how many fraction of samples has remained (0..1)
 };
@@ -272,15 +276,18 @@ PaulStretch::PaulStretch(float rap_,int in_bufsize_,float samplerate_){
 
    remained_samples=0.0;
 
+   hFFT=GetFFT(poolsize);
+
+   fft_window=new float[poolsize];
+   for (int i=0;i<poolsize;i++) fft_window[i]=1.0;
+   WindowFunc(3,poolsize,fft_window);
+
    fft_smps=new float[poolsize];
-   fft_s=new float[poolsize];
-   fft_c=new float[poolsize];
+   fft_buf=new float[poolsize];
    fft_freq=new float[poolsize];
-   fft_tmp=new float[poolsize];
    for (int i=0;i<poolsize;i++) {
       fft_smps[i]=0.0;
-      fft_c[i]=0.0;
-      fft_s[i]=0.0;
+      fft_buf[i]=0.0;
       fft_freq[i]=0.0;
    };
 
@@ -290,11 +297,11 @@ PaulStretch::~PaulStretch(){
    delete [] out_buf;
    delete [] old_out_smp_buf;
    delete [] in_pool;
+   delete [] fft_window;
    delete [] fft_smps;
-   delete [] fft_c;
-   delete [] fft_s;
+   delete [] fft_buf;
    delete [] fft_freq;
-   delete [] fft_tmp;
+   ReleaseFFT(hFFT);
 };
 
 void PaulStretch::set_rap(float newrap){
@@ -311,47 +318,41 @@ void PaulStretch::process(float *smps,int nsmps){
       int nleft=poolsize-nsmps;
 
       //move left the samples from the pool to make room for new samples
-      for (int i=0;i<nleft;i++) in_pool[i]=in_pool[i+nsmps];
+      memmove(in_pool,in_pool+nsmps,nleft*sizeof(float));
 
       //add new samples to the pool
-      for (int i=0;i<nsmps;i++) in_pool[i+nleft]=smps[i];
+      memcpy(in_pool+nleft,smps,nsmps*sizeof(float));
    };
 
-   //get the samples from the pool
-   for (int i=0;i<poolsize;i++) fft_smps[i]=in_pool[i];
-   WindowFunc(3,poolsize,fft_smps);
+   //get the windowed samples from the pool
+   for (int i=0;i<poolsize;i++) fft_buf[i]=in_pool[i]*fft_window[i];
 
-   RealFFT(poolsize,fft_smps,fft_c,fft_s);
+   //the real FFT leaves the spectrum in bit-reversed order, with the DC and
+   //Fs/2 bins packed into the first pair
+   RealFFTf(fft_buf,hFFT);
 
-   for (int i=0;i<poolsize/2;i++) fft_freq[i]=sqrt(fft_c[i]*fft_c[i]+fft_s[i]*fft_s[i]);
+   fft_freq[0]=fabs(fft_buf[0]);
+   for (int i=1;i<poolsize/2;i++){
+      float c=fft_buf[hFFT->BitReversed[i]];
+      float s=fft_buf[hFFT->BitReversed[i]+1];
+      fft_freq[i]=sqrt(c*c+s*s);
+   };
    process_spectrum(fft_freq);
 
 
    //put randomize phases to frequencies and do a IFFT
+   //(the inverse takes the bins in natural order)
    float inv_2p15_2pi=1.0/16384.0*(float)M_PI;
    for (int i=1;i<poolsize/2;i++){
       unsigned int random=(rand())&0x7fff;
       float phase=random*inv_2p15_2pi;
-      float s=fft_freq[i]*sin(phase);
-      float c=fft_freq[i]*cos(phase);
-
-
-      fft_c[i]=fft_c[poolsize-i]=c;
-
-      fft_s[i]=s;fft_s[poolsize-i]=-s;
+      fft_buf[2*i]=fft_freq[i]*cos(phase);
+      fft_buf[2*i+1]=fft_freq[i]*sin(phase);
    };
-   fft_c[0]=fft_s[0]=0.0;
-   fft_c[poolsize/2]=fft_s[poolsize/2]=0.0;
+   fft_buf[0]=fft_buf[1]=0.0;
 
-   FFT(poolsize,true,fft_c,fft_s,fft_smps,fft_tmp);
-
-   float max=0.0,max2=0.0;
-   for (int i=0;i<poolsize;i++){
-      float a=fabs(fft_tmp[i]);
-      if (a>max) max=a;
-      float b=fabs(fft_smps[i]);
-      if (b>max2) max2=b;
-   };
+   InverseRealFFTf(fft_buf,hFFT);
+   ReorderToTime(hFFT,fft_buf,fft_smps);
 
 
    //make the output buffer
@@ -0,0 +1,40 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealtimeRuns.cpp
+
+**********************************************************************/
+
+#include "../Audacity.h"
+
+#include "RealtimeRuns.h"
+
+sampleCount RealtimeProcessRuns(EffectClientInterface *client,
+                                int processor,
+                                float **clientIn,
+                                int numIn,
+                                float **clientOut,
+                                int numOut,
+                                sampleCount numSamples,
+                                sampleCount blockSize)
+{
+   sampleCount len = 0;
+   for (sampleCount block = 0; block < numSamples; block += blockSize)
+   {
+      sampleCount cnt = (block + blockSize > numSamples ? numSamples - block : blockSize);
+      len += client->RealtimeProcess(processor, clientIn, clientOut, cnt);
+
+      for (int i = 0 ; i < numIn; i++)
+      {
+         clientIn[i] += cnt;
+      }
+
+      for (int i = 0 ; i < numOut; i++)
+      {
+         clientOut[i] += cnt;
+      }
+   }
+
+   return len;
+}
@@ -0,0 +1,35 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  RealtimeRuns.h
+
+  How a realtime effect client is handed a device buffer: in runs of
+  the block size it agreed to.  Kept apart from Effect so that it can be
+  exercised without the rest of the application.
+
+**********************************************************************/
+
+#ifndef __AUDACITY_REALTIME_RUNS__
+#define __AUDACITY_REALTIME_RUNS__
+
+#include "audacity/EffectInterface.h"
+
+// Largest run of samples offered to a realtime effect in one call.
+// Longer device buffers are handed over in runs of at most this size.
+#define REALTIME_MAX_BLOCK_SIZE 4096
+
+// Passes numSamples samples from clientIn to clientOut through the given
+// processor of client, in runs of at most blockSize.  Advances the
+// numIn input and numOut output pointers past what was processed, and
+// returns the total the client reported.
+sampleCount RealtimeProcessRuns(EffectClientInterface *client,
+                                int processor,
+                                float **clientIn,
+                                int numIn,
+                                float **clientOut,
+                                int numOut,
+                                sampleCount numSamples,
+                                sampleCount blockSize);
+
+#endif
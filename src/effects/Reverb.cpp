@@ -62,14 +62,24 @@ bool EffectReverb::ProcessOneBlock(sampleCount len0, float * const * chans0)
          mP->chan[c].dry = (float *)fifo_write(&mP->chan[c].reverb.input_fifo, len1, chans[c]);
          reverb_process(&mP->chan[c].reverb, len1);
       }
-      if (mP->ichannels == 2)
+      if (mP->ichannels == 2) {
+         // One straight pass per output channel, in single precision
+         for (w = 0; w < 2; ++w) {
+            float * const out = chans[w];
+            float const * const dry = mP->chan[w].dry;
+            float const * const wet0 = mP->chan[0].wet[w];
+            float const * const wet1 = mP->chan[1].wet[w];
+            for (i = 0; i < len1; ++i)
+               out[i] = dryMult * dry[i] + .5f * (wet0[i] + wet1[i]);
+         }
+      }
+      else {
+         float * const out = chans[0];
+         float const * const dry = mP->chan[0].dry;
+         float const * const wet = mP->chan[0].wet[0];
          for (i = 0; i < len1; ++i)
-            for (w = 0; w < 2; ++w)
-               chans[w][i] = dryMult * mP->chan[w].dry[i] +
-                  .5 * (mP->chan[0].wet[w][i] + mP->chan[1].wet[w][i]);
-      else for (i = 0; i < len1; ++i)
-         for (w = 0; w < mP->ochannels; ++w)
-            chans[0][i] = dryMult * mP->chan[0].dry[i] + mP->chan[0].wet[w][i];
+            out[i] = dryMult * dry[i] + wet[i];
+      }
       len -= len1;
       for (c = 0; c < mP->ichannels; chans[c++] += len1);
    }
@@ -110,23 +110,46 @@ typedef struct {
    float   store;
 } filter_t;
 
-static float comb_process(filter_t * p,  /* gcc -O2 will inline this */
-      float const * input, float const * feedback, float const * hf_damping)
+/* Each filter runs over a whole block at a time, so that its state stays in
+ * registers, and the block is split where the delay line wraps so that the
+ * inner loops are free of branches. */
+
+static void comb_process(filter_t * p, size_t length,
+      float const * input, float * output, float feedback, float hf_damping)
 {
-   float output = *p->ptr;
-   p->store = output + (p->store - output) * *hf_damping;
-   *p->ptr = *input + p->store * *feedback;
-   filter_advance(p);
-   return output;
+   float * ptr = p->ptr, store = p->store;
+
+   while (length) {
+      size_t n = min(length, (size_t)(ptr - p->buffer) + 1);
+      length -= n;
+      while (n--) {
+         float out = *ptr;
+         store = out + (store - out) * hf_damping;
+         *ptr-- = *input++ + store * feedback;
+         *output++ += out;
+      }
+      if (ptr < p->buffer)
+         ptr += p->size;
+   }
+   p->ptr = ptr, p->store = store;
 }
 
-static float allpass_process(filter_t * p,  /* gcc -O2 will inline this */
-      float const * input)
+static void allpass_process(filter_t * p, size_t length, float * io)
 {
-   float output = *p->ptr;
-   *p->ptr = *input + output * .5;
-   filter_advance(p);
-   return output - *input;
+   float * ptr = p->ptr;
+
+   while (length) {
+      size_t n = min(length, (size_t)(ptr - p->buffer) + 1);
+      length -= n;
+      while (n--) {
+         float in = *io, out = *ptr;
+         *ptr-- = in + out * .5;
+         *io++ = out - in;
+      }
+      if (ptr < p->buffer)
+         ptr += p->size;
+   }
+   p->ptr = ptr;
 }
 
 typedef struct {double b0, b1, a1, i1, o1;} one_pole_t;
@@ -182,20 +205,21 @@ static void filter_array_process(filter_array_t * p,
       size_t length, float const * input, float * output,
       float const * feedback, float const * hf_damping, float const * gain)
 {
-   while (length--) {
-      float out = 0, in = *input++;
+   size_t i, n;
 
-      size_t i = array_length(comb_lengths) - 1;
-      do out += comb_process(p->comb + i, &in, feedback, hf_damping);
-      while (i--);
+   memset(output, 0, length * sizeof(*output));
+   i = array_length(comb_lengths) - 1;
+   do comb_process(p->comb + i, length, input, output, *feedback, *hf_damping);
+   while (i--);
 
-      i = array_length(allpass_lengths) - 1;
-      do out = allpass_process(p->allpass + i, &out);
-      while (i--);
+   i = array_length(allpass_lengths) - 1;
+   do allpass_process(p->allpass + i, length, output);
+   while (i--);
 
-      out = one_pole_process(&p->one_pole[0], out);
+   for (n = 0; n < length; ++n) {
+      float out = one_pole_process(&p->one_pole[0], output[n]);
       out = one_pole_process(&p->one_pole[1], out);
-      *output++ = out * *gain;
+      output[n] = out * *gain;
    }
 }
 
@@ -302,7 +302,7 @@ bool EffectScienFilter::ProcessOne(int count, WaveTrack * t,
    bool bLoopSuccess = true;
 
    for (int iPair = 0; iPair < (mOrder+1)/2; iPair++)
-      mpBiquad [iPair]->fPrevIn = mpBiquad [iPair]->fPrevPrevIn = mpBiquad [iPair]->fPrevOut = mpBiquad [iPair]->fPrevPrevOut = 0;
+      Biquad_Reset (mpBiquad [iPair]);
 
    while(len)
    {
@@ -312,12 +312,7 @@ bool EffectScienFilter::ProcessOne(int count, WaveTrack * t,
 
       t->Get((samplePtr)buffer, floatSample, s, block);
 
-      for (int iPair = 0; iPair < (mOrder+1)/2; iPair++)
-      {
-         mpBiquad[iPair]->pfIn = buffer;
-         mpBiquad[iPair]->pfOut = buffer;
-         Biquad_Process (mpBiquad[iPair], block);
-      }
+      Biquad_ProcessCascade (mpBiquad, (mOrder+1)/2, buffer, block);
       output->Append ((samplePtr)buffer, floatSample, block);
       len -= block;
       s += block;
@@ -17,14 +17,38 @@ effect that uses SoundTouch to do its processing (ChangeTempo
 #if USE_SOUNDTOUCH
 
 #include <math.h>
+#include <vector>
+
+#include <wx/thread.h>
 
 #include "../LabelTrack.h"
 #include "../WaveTrack.h"
 #include "../Project.h"
 #include "SoundTouchEffect.h"
+#include "SoundTouchSegments.h"
 #include "TimeWarper.h"
 #include "../NoteTrack.h"
 
+// Stretches one segment on its own thread
+class SoundTouchWorker : public wxThread
+{
+ public:
+   SoundTouchWorker(SoundTouchSegment *segment)
+      : wxThread(wxTHREAD_JOINABLE)
+   {
+      mSegment = segment;
+   }
+
+   virtual void *Entry()
+   {
+      mSegment->Stretch();
+      return NULL;
+   }
+
+ private:
+   SoundTouchSegment *mSegment;
+};
+
 bool EffectSoundTouch::ProcessLabelTrack(Track *track)
 {
 //   SetTimeWarper(new RegionTimeWarper(mCurT0, mCurT1,
@@ -126,8 +150,17 @@ bool EffectSoundTouch::Process()
                //Inform soundtouch there's 2 channels
                mSoundTouch->setChannels(2);
 
+               if (CanProcessSegments(leftTrack, start, end))
+               {
+                  WaveTrack *tracks[2] = { leftTrack, rightTrack };
+                  if (!ProcessSegments(tracks, 2, start, end))
+                  {
+                     bGoodResult = false;
+                     break;
+                  }
+               }
                //ProcessStereo() (implemented below) processes a stereo track
-               if (!ProcessStereo(leftTrack, rightTrack, start, end))
+               else if (!ProcessStereo(leftTrack, rightTrack, start, end))
                {
                   bGoodResult = false;
                   break;
@@ -141,8 +174,16 @@ bool EffectSoundTouch::Process()
                //Inform soundtouch there's a single channel
                mSoundTouch->setChannels(1);
 
+               if (CanProcessSegments(leftTrack, start, end))
+               {
+                  if (!ProcessSegments(&leftTrack, 1, start, end))
+                  {
+                     bGoodResult = false;
+                     break;
+                  }
+               }
                //ProcessOne() (implemented below) processes a single track
-               if (!ProcessOne(leftTrack, start, end))
+               else if (!ProcessOne(leftTrack, start, end))
                {
                   bGoodResult = false;
                   break;
@@ -392,4 +433,223 @@ bool EffectSoundTouch::ProcessStereoResults(const unsigned int outputCount,
    return true;
 }
 
+bool EffectSoundTouch::CanProcessSegments(WaveTrack *track,
+                                          sampleCount start, sampleCount end)
+{
+   // Only worth it with at least two segments and two CPUs to run them on
+   return wxThread::GetCPUCount() > 1 &&
+      end - start >= 2 * (sampleCount)(SEGMENT_SECONDS * track->GetRate());
+}
+
+// Returns the middle of the quietest 256-sample frame (over all channels)
+// in the searchLen samples either side of pos.
+sampleCount EffectSoundTouch::FindQuietPoint(WaveTrack **tracks, int numChannels,
+                                             sampleCount pos, sampleCount searchLen)
+{
+   const int frameLen = 256;
+   int numFrames = (int)(2 * searchLen / frameLen);
+   if (numFrames < 1)
+      return pos;
+
+   sampleCount first = pos - searchLen;
+   float *buffer = new float[numFrames * frameLen];
+   double *energy = new double[numFrames];
+   int f, j;
+
+   for (f = 0; f < numFrames; f++)
+      energy[f] = 0.0;
+
+   for (int c = 0; c < numChannels; c++) {
+      tracks[c]->Get((samplePtr)buffer, floatSample, first, numFrames * frameLen);
+      for (f = 0; f < numFrames; f++)
+         for (j = 0; j < frameLen; j++) {
+            float x = buffer[f * frameLen + j];
+            energy[f] += x * x;
+         }
+   }
+
+   int best = 0;
+   for (f = 1; f < numFrames; f++)
+      if (energy[f] < energy[best])
+         best = f;
+
+   delete[] buffer;
+   delete[] energy;
+
+   return first + best * frameLen + frameLen / 2;
+}
+
+// Stretches a long selection as independent segments, several at once,
+// each with its own SoundTouch.  The segments overlap around each cut, and
+// their outputs are lined up and crossfaded there; the cuts are put at
+// quiet points so the seams are hard to hear.  A round of segments is read,
+// processed and spliced before the next one is read, so memory use doesn't
+// grow with the length of the selection.
+bool EffectSoundTouch::ProcessSegments(WaveTrack **tracks, int numChannels,
+                                       sampleCount start, sampleCount end)
+{
+   double rate = tracks[0]->GetRate();
+
+   // Output samples per input sample.  The warpers of both subclasses are
+   // linear over the selection.
+   double ratio = (GetTimeWarper()->Warp(mCurT1) - GetTimeWarper()->Warp(mCurT0)) /
+                  (mCurT1 - mCurT0);
+
+   sampleCount segmentLen = (sampleCount)(SEGMENT_SECONDS * rate);
+   sampleCount searchLen = (sampleCount)(SEGMENT_SEARCH_SECONDS * rate);
+   sampleCount overlap = (sampleCount)(SEGMENT_OVERLAP_SECONDS * rate);
+   sampleCount preroll = (sampleCount)(SEGMENT_PREROLL_SECONDS * rate);
+
+   // The last segment takes up the remainder, so it's never short
+   std::vector<sampleCount> cuts;
+   cuts.push_back(start);
+   for (sampleCount pos = start + segmentLen; pos + segmentLen <= end; pos += segmentLen)
+      cuts.push_back(FindQuietPoint(tracks, numChannels, pos, searchLen));
+   cuts.push_back(end);
+
+   int numSegments = (int)cuts.size() - 1;
+   int numThreads = wxMin(wxThread::GetCPUCount(), numSegments);
+
+   // For the progress meter: the input, pre- and post-roll included, that
+   // all the segments together will be fed
+   double totalLen = 0.0;
+   int k;
+   for (k = 0; k < numSegments; k++) {
+      SoundTouchSegment seg;
+      seg.Place(cuts, k, overlap, preroll, ratio);
+      totalLen += seg.inEnd - seg.inStart;
+   }
+
+   WaveTrack **outputTracks = new WaveTrack*[numChannels];
+   int c;
+   for (c = 0; c < numChannels; c++)
+      outputTracks[c] = mFactory->NewWaveTrack(tracks[c]->GetSampleFormat(),
+                                               tracks[c]->GetRate());
+
+   SoundTouchSegment *segments = new SoundTouchSegment[numThreads];
+   SoundTouchWorker **workers = new SoundTouchWorker*[numThreads];
+   SoundTouchSplicer splicer(numChannels,
+                             (sampleCount)(SEGMENT_ALIGN_SECONDS * rate * ratio));
+   std::vector<float> result;
+   double doneLen = 0.0;
+   bool bGoodResult = true;
+   bool bSpliced = true;
+
+   for (int first = 0; first < numSegments && bGoodResult && bSpliced; first += numThreads) {
+      int count = wxMin(numThreads, numSegments - first);
+      int i;
+
+      for (i = 0; i < count; i++) {
+         SoundTouchSegment &seg = segments[i];
+
+         seg.Place(cuts, first + i, overlap, preroll, ratio);
+         seg.numChannels = numChannels;
+
+         sampleCount len = seg.inEnd - seg.inStart;
+         float *buffer = new float[len];
+         seg.input = new float[len * numChannels];
+         for (c = 0; c < numChannels; c++) {
+            tracks[c]->Get((samplePtr)buffer, floatSample, seg.inStart, len);
+            for (sampleCount j = 0; j < len; j++)
+               seg.input[j * numChannels + c] = buffer[j];
+         }
+         delete[] buffer;
+
+         seg.soundTouch = NewSoundTouch();
+         seg.soundTouch->setChannels(numChannels);
+         seg.soundTouch->setSampleRate((unsigned int)(rate + 0.5));
+
+         // A segment that can't have a thread of its own is stretched on
+         // this one instead, below
+         workers[i] = new SoundTouchWorker(&seg);
+         if (workers[i]->Create() != wxTHREAD_NO_ERROR ||
+             workers[i]->Run() != wxTHREAD_NO_ERROR) {
+            delete workers[i];
+            workers[i] = NULL;
+         }
+      }
+
+      for (i = 0; i < count; i++)
+         if (!workers[i])
+            segments[i].Stretch();
+
+      // Keep the progress meter moving, and let the user cancel, while the
+      // workers run.  Waiting on the first unfinished segment paces this.
+      for (;;) {
+         bool finished = true;
+         for (i = 0; i < count; i++)
+            if (!segments[i].WaitFinished(finished ? 50 : 0))
+               finished = false;
+         if (finished)
+            break;
+
+         double fed = doneLen;
+         for (i = 0; i < count; i++)
+            fed += segments[i].GetDone();
+
+         if (bGoodResult && TrackProgress(mCurTrackNum, fed / totalLen)) {
+            bGoodResult = false;
+            for (i = 0; i < count; i++)
+               segments[i].Cancel();
+         }
+      }
+
+      for (i = 0; i < count; i++) {
+         if (workers[i]) {
+            workers[i]->Wait();
+            delete workers[i];
+         }
+      }
+
+      // Splice the outputs, in order
+      for (i = 0; i < count && bGoodResult && bSpliced; i++) {
+         bSpliced = splicer.Splice(segments[i], result);
+         doneLen += segments[i].inEnd - segments[i].inStart;
+      }
+
+      for (i = 0; i < count; i++)
+         segments[i].Clear();
+
+      if (bGoodResult && bSpliced && !result.empty()) {
+         sampleCount len = (sampleCount)(result.size() / numChannels);
+         for (c = 0; c < numChannels; c++)
+            outputTracks[c]->Append((samplePtr)(&result[0] + c), floatSample,
+                                    len, numChannels);
+         result.clear();
+      }
+   }
+
+   delete[] workers;
+   delete[] segments;
+
+   if (bGoodResult && bSpliced) {
+      for (c = 0; c < numChannels; c++) {
+         // Flush the output WaveTrack (since it's buffered, too)
+         outputTracks[c]->Flush();
+
+         // Take the output track and insert it in place of the original
+         // sample data
+         tracks[c]->ClearAndPaste(mCurT0, mCurT1, outputTracks[c], true, false, GetTimeWarper());
+
+         double newLength = outputTracks[c]->GetEndTime();
+         m_maxNewLength = wxMax(m_maxNewLength, newLength);
+      }
+   }
+
+   for (c = 0; c < numChannels; c++)
+      delete outputTracks[c];
+   delete[] outputTracks;
+
+   // Some segment came out too short to be spliced, which shouldn't happen
+   // with the pre- and post-roll we give them.  The tracks haven't been
+   // touched yet, so just do it the slow way.
+   if (bGoodResult && !bSpliced) {
+      if (numChannels == 2)
+         return ProcessStereo(tracks[0], tracks[1], start, end);
+      return ProcessOne(tracks[0], start, end);
+   }
+
+   return bGoodResult;
+}
+
 #endif // USE_SOUNDTOUCH
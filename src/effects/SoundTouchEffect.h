@@ -44,6 +44,10 @@ class EffectSoundTouch:public Effect {
 #endif
 
  protected:
+   // Returns a SoundTouch set up for the subclass's tempo or pitch change.
+   // Besides mSoundTouch, one is made for each segment processed in parallel.
+   virtual SoundTouch *NewSoundTouch() = 0;
+
    SoundTouch *mSoundTouch;
    double mCurT0;
    double mCurT1;
@@ -60,6 +64,12 @@ class EffectSoundTouch:public Effect {
                               WaveTrack* outputLeftTrack,
                               WaveTrack* outputRightTrack);
 
+   bool CanProcessSegments(WaveTrack *track, sampleCount start, sampleCount end);
+   bool ProcessSegments(WaveTrack **tracks, int numChannels,
+                        sampleCount start, sampleCount end);
+   sampleCount FindQuietPoint(WaveTrack **tracks, int numChannels,
+                              sampleCount pos, sampleCount searchLen);
+
    int    mCurTrackNum;
 
    double m_maxNewLength;
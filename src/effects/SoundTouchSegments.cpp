@@ -0,0 +1,250 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SoundTouchSegments.cpp
+
+*******************************************************************//**
+
+\class SoundTouchSegment
+\brief One segment of a long selection, stretched by its own SoundTouch.
+
+\class SoundTouchSplicer
+\brief Crossfades the outputs of SoundTouchSegments together, lining each
+one up with the one before.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+
+#if USE_SOUNDTOUCH
+
+#include <math.h>
+#include <stdlib.h>
+
+#include "SoundTouchSegments.h"
+
+SoundTouchSegment::SoundTouchSegment()
+   : mFinishedCondition(mMutex)
+{
+   inStart = 0;
+   inEnd = 0;
+   outBase = 0;
+   fadeStart = -1;
+   fadeEnd = -1;
+   numChannels = 1;
+   input = NULL;
+   soundTouch = NULL;
+   mDone = 0;
+   mFinished = false;
+   mCancel = false;
+}
+
+SoundTouchSegment::~SoundTouchSegment()
+{
+   Clear();
+}
+
+void SoundTouchSegment::Clear()
+{
+   delete[] input;
+   input = NULL;
+   delete soundTouch;
+   soundTouch = NULL;
+   std::vector<float>().swap(output);
+
+   wxMutexLocker locker(mMutex);
+   mDone = 0;
+   mFinished = false;
+   mCancel = false;
+}
+
+sampleCount SoundTouchSegment::GetDone()
+{
+   wxMutexLocker locker(mMutex);
+   return mDone;
+}
+
+bool SoundTouchSegment::WaitFinished(unsigned long ms)
+{
+   wxMutexLocker locker(mMutex);
+   if (!mFinished && ms > 0)
+      mFinishedCondition.WaitTimeout(ms);
+   return mFinished;
+}
+
+void SoundTouchSegment::Cancel()
+{
+   wxMutexLocker locker(mMutex);
+   mCancel = true;
+}
+
+bool SoundTouchSegment::IsCancelled()
+{
+   wxMutexLocker locker(mMutex);
+   return mCancel;
+}
+
+static sampleCount OutputPosition(sampleCount s, sampleCount start, double ratio)
+{
+   return (sampleCount)floor((s - start) * ratio + 0.5);
+}
+
+void SoundTouchSegment::Place(const std::vector<sampleCount> &cuts, int k,
+                              sampleCount overlap, sampleCount preroll,
+                              double ratio)
+{
+   sampleCount start = cuts.front();
+   sampleCount end = cuts.back();
+   bool last = (k + 2 == (int)cuts.size());
+
+   inStart = (k == 0) ? start : cuts[k] - overlap - preroll;
+   if (inStart < start)
+      inStart = start;
+   inEnd = last ? end : cuts[k + 1] + overlap + preroll;
+   if (inEnd > end)
+      inEnd = end;
+
+   outBase = OutputPosition(inStart, start, ratio);
+   fadeStart = last ? -1 : OutputPosition(cuts[k + 1] - overlap, start, ratio);
+   fadeEnd = last ? -1 : OutputPosition(cuts[k + 1] + overlap, start, ratio);
+}
+
+void SoundTouchSegment::Stretch()
+{
+   const sampleCount chunk = 8192;
+   sampleCount len = inEnd - inStart;
+
+   for (sampleCount s = 0; s < len && !IsCancelled(); s += chunk) {
+      sampleCount block = (len - s < chunk) ? len - s : chunk;
+      soundTouch->putSamples(&input[s * numChannels], (unsigned int)block);
+      Receive();
+
+      wxMutexLocker locker(mMutex);
+      mDone = s + block;
+   }
+
+   if (!IsCancelled()) {
+      soundTouch->flush();
+      Receive();
+   }
+
+   wxMutexLocker locker(mMutex);
+   mFinished = true;
+   mFinishedCondition.Broadcast();
+}
+
+void SoundTouchSegment::Receive()
+{
+   unsigned int count;
+
+   while ((count = soundTouch->numSamples()) > 0) {
+      size_t have = output.size();
+      output.resize(have + count * numChannels);
+      count = soundTouch->receiveSamples(&output[have], count);
+      output.resize(have + count * numChannels);
+   }
+}
+
+SoundTouchSplicer::SoundTouchSplicer(int numChannels, sampleCount searchLen)
+{
+   mNumChannels = numChannels;
+   mSearchLen = searchLen;
+   mWritten = 0;
+}
+
+// Returns the shift from base, within the search length, at which output
+// best matches the tail it is to fade into.
+sampleCount SoundTouchSplicer::FindShift(const float *output, sampleCount len,
+                                         sampleCount base)
+{
+   sampleCount fadeLen = (sampleCount)(mTail.size() / mNumChannels);
+   size_t n = mTail.size();
+   const float *tail = &mTail[0];
+
+   sampleCount bestShift = 0;
+   double bestScore = 0.0;
+   bool found = false;
+
+   for (sampleCount shift = -mSearchLen; shift <= mSearchLen; shift++) {
+      sampleCount first = mWritten - (base + shift);
+      if (first < 0 || first + fadeLen > len)
+         continue;
+
+      // Correlation, normalised by the energy of the part of output it
+      // covers (the tail's energy is the same at every shift)
+      const float *out = output + first * mNumChannels;
+      double sum = 0.0;
+      double energy = 0.0;
+      for (size_t i = 0; i < n; i++) {
+         sum += tail[i] * out[i];
+         energy += out[i] * out[i];
+      }
+      double score = (energy > 0.0) ? sum / sqrt(energy) : 0.0;
+
+      if (!found || score > bestScore ||
+          (score == bestScore && labs((long)shift) < labs((long)bestShift))) {
+         bestShift = shift;
+         bestScore = score;
+         found = true;
+      }
+   }
+
+   return bestShift;
+}
+
+bool SoundTouchSplicer::Splice(const SoundTouchSegment &segment,
+                               std::vector<float> &result)
+{
+   const std::vector<float> &output = segment.output;
+   sampleCount base = segment.outBase;
+   sampleCount fadeStart = segment.fadeStart;
+   sampleCount fadeEnd = segment.fadeEnd;
+   sampleCount len = (sampleCount)(output.size() / mNumChannels);
+   sampleCount fadeLen = (sampleCount)(mTail.size() / mNumChannels);
+   const float *out = output.empty() ? NULL : &output[0];
+
+   if (fadeLen > 0)
+      base += FindShift(out, len, base);
+
+   // Frames of output before mWritten don't get used
+   sampleCount pos = mWritten - base;
+   if (pos < 0 || pos + fadeLen > len)
+      return false;
+
+   bool last = (fadeStart < 0);
+   sampleCount keepEnd = last ? base + len : fadeStart;
+   if (keepEnd < mWritten + fadeLen || (!last && fadeEnd - base > len))
+      return false;
+
+   // Fade out the tail of the previous segment under the start of this one
+   size_t have = result.size();
+   result.resize(have + (size_t)((keepEnd - mWritten) * mNumChannels));
+   float *dest = &result[have];
+
+   for (sampleCount j = 0; j < fadeLen; j++) {
+      float w = (float)((j + 0.5) / fadeLen);
+      for (int c = 0; c < mNumChannels; c++) {
+         size_t i = (size_t)(j * mNumChannels + c);
+         dest[i] = mTail[i] * (1.0f - w) +
+                   out[(pos + j) * mNumChannels + c] * w;
+      }
+   }
+
+   // Then the rest, up to where the next segment's fade starts
+   for (size_t i = (size_t)(fadeLen * mNumChannels);
+        i < (size_t)((keepEnd - mWritten) * mNumChannels); i++)
+      dest[i] = out[pos * mNumChannels + i];
+
+   mWritten = keepEnd;
+
+   if (last)
+      mTail.clear();
+   else
+      mTail.assign(out + (fadeStart - base) * mNumChannels,
+                   out + (fadeEnd - base) * mNumChannels);
+
+   return true;
+}
+
+#endif // USE_SOUNDTOUCH
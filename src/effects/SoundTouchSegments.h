@@ -0,0 +1,138 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  SoundTouchSegments.h
+
+  Stretches a long selection as separate segments, each with its own
+  SoundTouch, and splices the results back together.  EffectSoundTouch
+  uses these to run several segments at once; they don't depend on
+  tracks, so they can be tested on their own.
+
+**********************************************************************/
+
+#include "../Audacity.h"
+
+#if USE_SOUNDTOUCH
+
+#ifndef __AUDACITY_SOUNDTOUCH_SEGMENTS__
+#define __AUDACITY_SOUNDTOUCH_SEGMENTS__
+
+#include <vector>
+
+#include <wx/thread.h>
+
+#include "../Sequence.h"
+
+// Soundtouch defines these as well, so get rid of them before including
+#undef PACKAGE_NAME
+#undef PACKAGE_STRING
+#undef PACKAGE_TARNAME
+#undef PACKAGE_VERSION
+#undef PACKAGE_BUGREPORT
+#include "SoundTouch.h"
+
+// Long selections are cut into segments of about this length, which are
+// stretched at the same time by separate SoundTouch instances and then
+// spliced back together.
+#define SEGMENT_SECONDS 20.0
+// Each cut is moved to the quietest point this close to where it would
+// otherwise fall, so that the splice is as inaudible as possible.
+#define SEGMENT_SEARCH_SECONDS 0.25
+// Segments run on this far past each cut, and are crossfaded over
+// twice this length (before stretching).
+#define SEGMENT_OVERLAP_SECONDS 0.05
+// And this much further again, so that the crossfades are clear of the
+// start-up of each SoundTouch and of what it makes up when flushed.
+#define SEGMENT_PREROLL_SECONDS 0.5
+// How far (after stretching) each segment may be moved to line it up with
+// the one before.
+#define SEGMENT_ALIGN_SECONDS 0.02
+
+class SoundTouchSegment
+{
+ public:
+   SoundTouchSegment();
+   ~SoundTouchSegment();
+
+   // Feeds the whole input through soundTouch, then flushes it, collecting
+   // the output as it goes.  Touches nothing but this segment, so it can
+   // run on a worker thread.
+   void Stretch();
+
+   // Frees the input, output and SoundTouch, ready for the next segment
+   void Clear();
+
+   // For the thread waiting on Stretch(): input frames fed so far
+   sampleCount GetDone();
+   // Waits up to ms milliseconds for Stretch() to return; true if it has
+   bool WaitFinished(unsigned long ms);
+   // Makes Stretch() give up early
+   void Cancel();
+
+   // Sets up the ranges for the k'th of the segments between cuts (the
+   // first and last cuts being the ends of the selection).  Each segment
+   // runs overlap past the cuts at its ends, so that it can be crossfaded
+   // with its neighbours, plus preroll more, so that neither SoundTouch's
+   // start-up nor its flush falls in the crossfade.  The first segment
+   // starts, and the last ends, exactly where the selection does.
+   // ratio is output samples per input sample.
+   void Place(const std::vector<sampleCount> &cuts, int k,
+              sampleCount overlap, sampleCount preroll, double ratio);
+
+   sampleCount inStart;       // input range, including pre- and post-roll
+   sampleCount inEnd;
+   // Where output[0] would go in the result if it were exactly in step,
+   // and the part of the result where it fades into the next segment
+   // (both -1 for the last segment)
+   sampleCount outBase;
+   sampleCount fadeStart;
+   sampleCount fadeEnd;
+   int numChannels;
+   float *input;              // interleaved, (inEnd - inStart) frames
+   std::vector<float> output; // interleaved
+   soundtouch::SoundTouch *soundTouch;
+
+ private:
+   void Receive();
+   bool IsCancelled();
+
+   // Shared between Stretch() and the thread waiting for it
+   wxMutex mMutex;
+   wxCondition mFinishedCondition;
+   sampleCount mDone;
+   bool mFinished;
+   bool mCancel;
+};
+
+// Joins the outputs of consecutive segments into one.  Each segment's
+// output is crossfaded into the end of the one before.  Segments come from
+// SoundTouch instances started at different places, so the output isn't
+// exactly where the stretch ratio says it should be.  Each one is shifted
+// by up to the search length to line it up with the audio it fades into.
+class SoundTouchSplicer
+{
+ public:
+   SoundTouchSplicer(int numChannels, sampleCount searchLen);
+
+   // Appends the next segment's output to result, holding back the part
+   // that is to fade into the segment after it.  Returns false if the
+   // output doesn't reach far enough either side to be spliced.
+   bool Splice(const SoundTouchSegment &segment, std::vector<float> &result);
+
+   // Frames of joined output so far, not counting what's held back
+   sampleCount GetWritten() const { return mWritten; }
+
+ private:
+   sampleCount FindShift(const float *output, sampleCount len,
+                         sampleCount base);
+
+   int mNumChannels;
+   sampleCount mSearchLen;
+   sampleCount mWritten;
+   std::vector<float> mTail;  // held back to fade out under the next segment
+};
+
+#endif
+
+#endif
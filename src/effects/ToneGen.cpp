@@ -147,6 +147,7 @@ bool EffectToneGen::MakeTone(float *buffer, sampleCount len)
    int k;
 
    double frequencyQuantum;
+   double frequencyRatio = 1.0;
    double BlendedFrequency;
    double BlendedAmplitude;
    double BlendedLogFrequency = 0.0f;
@@ -169,12 +170,34 @@ bool EffectToneGen::MakeTone(float *buffer, sampleCount len)
       frequencyQuantum = (logFrequency[1]-logFrequency[0]) / numSamples;
       BlendedLogFrequency = logFrequency[0] + frequencyQuantum * mSample;
       BlendedFrequency = pow( 10.0, (double)BlendedLogFrequency );
+      // stepping the log frequency is the same as scaling the frequency
+      frequencyRatio = pow( 10.0, frequencyQuantum );
    } else {
       // this for regular case, linear interpolation
       frequencyQuantum = (frequency[1]-frequency[0]) / numSamples;
       BlendedFrequency = frequency[0] + frequencyQuantum * mSample;
    }
 
+   // A steady sine needs no sin() per sample: rotate a unit phasor by the
+   // phase increment instead.  The phasor is set from the exact phase at the
+   // start of every block, so rounding cannot build up over long tones.
+   if (waveform == 0 && frequencyQuantum == 0.0) {
+      double w = pre2PI * BlendedFrequency / mCurRate;
+      double cw = cos(w), sw = sin(w);
+      double re = cos(pre2PI * mPositionInCycles / mCurRate);
+      double im = sin(pre2PI * mPositionInCycles / mCurRate);
+      for (i = 0; i < len; i++) {
+         buffer[i] = BlendedAmplitude * (float) im;
+         double t = re * cw - im * sw;
+         im = re * sw + im * cw;
+         re = t;
+         BlendedAmplitude += amplitudeQuantum;
+      }
+      mPositionInCycles += len * BlendedFrequency;
+      mSample += len;
+      return true;
+   }
+
    // synth loop
    for (i = 0; i < len; i++) {
       switch (waveform) {
@@ -188,16 +211,34 @@ bool EffectToneGen::MakeTone(float *buffer, sampleCount len)
          f = (2 * modf(mPositionInCycles/mCurRate+0.5f, &throwaway)) -1.0f;
          break;
       case 3:    //square, no alias.  Good down to 110Hz @ 44100Hz sampling.
+         {
          //do fundamental (k=1) outside loop
-         b = (1. + cos((pre2PI * BlendedFrequency)/mCurRate))/pre4divPI;  //scaling
-         f = (float) pre4divPI * sin(pre2PI * mPositionInCycles/mCurRate);
+         double w = (pre2PI * BlendedFrequency)/mCurRate;
+         double phi = pre2PI * mPositionInCycles/mCurRate;
+         double cw = cos(w), sphi = sin(phi);
+         b = (1. + cw)/pre4divPI;  //scaling
+         f = (float) pre4divPI * sphi;
+         // The odd harmonics and their window weights follow from the
+         // fundamental by the Chebyshev recurrence
+         //   x((k+2)t) = 2 cos(2t) x(k t) - x((k-2)t)
+         // so only the fundamental needs sin() and cos().
+         double c2w = 2. * cos(2. * w), c2phi = 2. * cos(2. * phi);
+         double cosPrev = cw, cosCur = c2w * cw - cw;   // cos(w), cos(3w)
+         double sinPrev = -sphi, sinCur = sphi;         // sin(-phi), sin(phi)
          for(k=3; (k<200) && (k * BlendedFrequency < mCurRate/2.); k+=2)
             {
+               double sinNext = c2phi * sinCur - sinPrev;   // sin(k phi)
+               sinPrev = sinCur;
+               sinCur = sinNext;
                //Hanning Window in freq domain
-               a = 1. + cos((pre2PI * k * BlendedFrequency)/mCurRate);
+               a = 1. + cosCur;
                //calc harmonic, apply window, scale to amplitude of fundamental
-               f += (float) a * sin(pre2PI * mPositionInCycles/mCurRate * k)/(b*k);
+               f += (float) a * sinCur/(b*k);
+               double cosNext = c2w * cosCur - cosPrev;
+               cosPrev = cosCur;
+               cosCur = cosNext;
             }
+         }
       }
       // insert value in buffer
       buffer[i] = BlendedAmplitude * f;
@@ -205,8 +246,7 @@ bool EffectToneGen::MakeTone(float *buffer, sampleCount len)
       mPositionInCycles += BlendedFrequency;
       BlendedAmplitude += amplitudeQuantum;
       if (mbLogInterpolation) {
-         BlendedLogFrequency += frequencyQuantum;
-         BlendedFrequency = pow( 10.0, (double)BlendedLogFrequency);
+         BlendedFrequency *= frequencyRatio;
       } else {
          BlendedFrequency += frequencyQuantum;
       }
@@ -209,12 +209,31 @@ bool EffectTruncSilence::Process()
          // End of optimization
          //
 
+         // Work a block at a time where possible, so that the summaries
+         // of whole blocks can answer the query below
+         sampleCount count = wxMin(wt->GetBestBlockSize(index), blockLen);
+
          // Limit size of current block if we've reached the end
-         sampleCount count = blockLen;
          if ((index + count) > end) {
             count = end - index;
          }
 
+         // If the summaries show that every sample is below the threshold,
+         // the whole stretch is silent and needn't be read.  The range is
+         // widened by a sample each side, so that rounding in the time
+         // conversions can't leave a loud sample out.
+         float blockMin, blockMax;
+         if (wt->GetMinMax(&blockMin, &blockMax,
+                           wt->LongSamplesToTime(index - 1),
+                           wt->LongSamplesToTime(index + count + 1)) &&
+             blockMax < truncDbSilenceThreshold &&
+             -blockMin < truncDbSilenceThreshold)
+         {
+            silentFrames += count;
+            index += count;
+            continue;
+         }
+
          // Fill buffer
          wt->Get((samplePtr)(buffer), floatSample, index, count);
 
@@ -46,8 +46,6 @@
 // EffectWahwah
 //
 
-#define lfoskipsamples 30
-
 EffectWahwah::EffectWahwah()
 {
    freq = float(1.5);
@@ -106,57 +104,18 @@ bool EffectWahwah::TransferParameters( Shuttle & shuttle )
 
 bool EffectWahwah::NewTrackSimpleMono()
 {
-   lfoskip = freq * 2 * M_PI / mCurRate;
-   skipcount = 0;
-   xn1 = 0;
-   xn2 = 0;
-   yn1 = 0;
-   yn2 = 0;
-   b0 = 0;
-   b1 = 0;
-   b2 = 0;
-   a0 = 0;
-   a1 = 0;
-   a2 = 0;
-
-   phase = startphase;
+   float phase = startphase;
    if (mCurChannel == Track::RightChannel)
       phase += (float)M_PI;
 
+   mFilter.Init(mCurRate, freq, phase, depth, freqofs, res);
+
    return true;
 }
 
 bool EffectWahwah::ProcessSimpleMono(float *buffer, sampleCount len)
 {
-   float frequency, omega, sn, cs, alpha;
-   float in, out;
-
-   for (int i = 0; i < len; i++) {
-      in = buffer[i];
-
-      if ((skipcount++) % lfoskipsamples == 0) {
-         frequency = (1 + cos(skipcount * lfoskip + phase)) / 2;
-         frequency = frequency * depth * (1 - freqofs) + freqofs;
-         frequency = exp((frequency - 1) * 6);
-         omega = M_PI * frequency;
-         sn = sin(omega);
-         cs = cos(omega);
-         alpha = sn / (2 * res);
-         b0 = (1 - cs) / 2;
-         b1 = 1 - cs;
-         b2 = (1 - cs) / 2;
-         a0 = 1 + alpha;
-         a1 = -2 * cs;
-         a2 = 1 - alpha;
-      };
-      out = (b0 * in + b1 * xn1 + b2 * xn2 - a1 * yn1 - a2 * yn2) / a0;
-      xn2 = xn1;
-      xn1 = in;
-      yn2 = yn1;
-      yn1 = out;
-
-      buffer[i] = (float) out;
-   }
+   mFilter.Process(buffer, len);
 
    return true;
 }
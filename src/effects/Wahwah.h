@@ -31,6 +31,7 @@ class wxSizer;
 class wxTextCtrl;
 
 #include "SimpleMono.h"
+#include "WahwahFilter.h"
 
 class EffectWahwah:public EffectSimpleMono {
 
@@ -66,11 +67,7 @@ class EffectWahwah:public EffectSimpleMono {
 
    virtual bool ProcessSimpleMono(float *buffer, sampleCount len);
 
-   float phase;
-   float lfoskip;
-   unsigned long skipcount;
-   float xn1, xn2, yn1, yn2;
-   float b0, b1, b2, a0, a1, a2;
+   WahwahFilter mFilter;
 
 /* Parameters:
    freq - LFO frequency
@@ -0,0 +1,66 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WahwahFilter.cpp
+
+  Nasca Octavian Paul (Paul Nasca)
+
+*******************************************************************//**
+
+\class WahwahFilter
+\brief The swept biquad of EffectWahwah.
+
+*//*******************************************************************/
+
+#include "../Audacity.h"
+#include <math.h>
+
+#include "WahwahFilter.h"
+
+#define lfoskipsamples 30
+
+void WahwahFilter::Init(double rate, float freq, float phase,
+                        float depth, float freqofs, float res)
+{
+   mLfoSkip = freq * 2 * M_PI / rate;
+   mSkipCount = 0;
+   Biquad_Reset(&mBiquad);
+
+   mPhase = phase;
+   mDepth = depth;
+   mFreqOfs = freqofs;
+   mRes = res;
+}
+
+void WahwahFilter::Process(float *buffer, sampleCount len)
+{
+   float frequency, omega, sn, cs, alpha;
+
+   // The LFO only moves the filter every lfoskipsamples, so run the biquad
+   // over each stretch between updates with its coefficients held.
+   mBiquad.pfIn = mBiquad.pfOut = buffer;
+   while (len > 0) {
+      if (mSkipCount % lfoskipsamples == 0) {
+         frequency = (1 + cos((mSkipCount + 1) * mLfoSkip + mPhase)) / 2;
+         frequency = frequency * mDepth * (1 - mFreqOfs) + mFreqOfs;
+         frequency = exp((frequency - 1) * 6);
+         omega = M_PI * frequency;
+         sn = sin(omega);
+         cs = cos(omega);
+         alpha = sn / (2 * mRes);
+         Biquad_SetCoeffs(&mBiquad,
+                          (1 - cs) / 2, 1 - cs, (1 - cs) / 2,
+                          1 + alpha, -2 * cs, 1 - alpha);
+      }
+
+      int run = lfoskipsamples - (int)(mSkipCount % lfoskipsamples);
+      if (run > len)
+         run = (int)len;
+      Biquad_Process(&mBiquad, run);
+      mBiquad.pfIn += run;
+      mBiquad.pfOut += run;
+      mSkipCount += run;
+      len -= run;
+   }
+}
@@ -0,0 +1,42 @@
+/**********************************************************************
+
+  Audacity: A Digital Audio Editor
+
+  WahwahFilter.h
+
+  Nasca Octavian Paul (Paul Nasca)
+
+  The LFO-swept lowpass behind Wahwah, kept apart from the effect so
+  that it can be tested on its own.
+
+**********************************************************************/
+
+#ifndef __AUDACITY_WAHWAH_FILTER__
+#define __AUDACITY_WAHWAH_FILTER__
+
+#include "../Audacity.h"
+#include "../Sequence.h"
+#include "Biquad.h"
+
+class WahwahFilter
+{
+ public:
+   /// Starts a track at the given rate.  freq is the LFO frequency and
+   /// phase its start phase in radians; depth and freqofs are from 0 to 1,
+   /// and res must be greater than 0.
+   void Init(double rate, float freq, float phase,
+             float depth, float freqofs, float res);
+
+   /// Filters buffer in place, carrying the LFO and the filter's state on
+   /// to the next call.
+   void Process(float *buffer, sampleCount len);
+
+ private:
+   float mPhase;
+   float mLfoSkip;
+   unsigned long mSkipCount;
+   float mDepth, mFreqOfs, mRes;
+   BiquadStruct mBiquad;
+};
+
+#endif
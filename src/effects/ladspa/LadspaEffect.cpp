@@ -954,6 +954,9 @@ sampleCount LadspaEffect::ProcessBlock(float **inbuf, float **outbuf, sampleCoun
 
 bool LadspaEffect::RealtimeInitialize()
 {
+   // Report the latency once for each stream, as for each offline run
+   mLatencyDone = false;
+
    return true;
 }
 
@@ -287,5 +287,32 @@ bool SpectrumPrefs::Apply()
    ShuttleGui S(this, eIsSavingToPrefs);
    PopulateOrExchange(S);
 
+   SpectrogramSettings::defaults().UpdatePrefs();
+
    return true;
 }
+
+SpectrogramSettings::SpectrogramSettings()
+{
+   UpdatePrefs();
+}
+
+SpectrogramSettings &SpectrogramSettings::defaults()
+{
+   static SpectrogramSettings instance;
+   return instance;
+}
+
+void SpectrogramSettings::UpdatePrefs()
+{
+   minFreq = gPrefs->Read(wxT("/Spectrum/MinFreq"), 0L);
+   maxFreq = gPrefs->Read(wxT("/Spectrum/MaxFreq"), 8000L);
+   range = gPrefs->Read(wxT("/Spectrum/Range"), 80L);
+   gain = gPrefs->Read(wxT("/Spectrum/Gain"), 20L);
+   frequencyGain = gPrefs->Read(wxT("/Spectrum/FrequencyGain"), 0L);
+   windowType = gPrefs->Read(wxT("/Spectrum/WindowType"), 3L);
+   windowSize = gPrefs->Read(wxT("/Spectrum/FFTSize"), 256L);
+#ifdef EXPERIMENTAL_FFT_SKIP_POINTS
+   fftSkipPoints = gPrefs->Read(wxT("/Spectrum/FFTSkipPoints"), 0L);
+#endif //EXPERIMENTAL_FFT_SKIP_POINTS
+}
@@ -30,6 +30,31 @@
 
 #include "PrefsPanel.h"
 
+/// The spectrogram settings as last applied, so that drawing code can read
+/// plain fields instead of looking each one up in gPrefs on every redraw.
+class SpectrogramSettings
+{
+ public:
+   static SpectrogramSettings &defaults();
+
+   /// Reread everything from gPrefs; SpectrumPrefs::Apply() calls this
+   void UpdatePrefs();
+
+   int minFreq;         // "/Spectrum/MinFreq"
+   int maxFreq;         // "/Spectrum/MaxFreq"
+   int range;           // "/Spectrum/Range"
+   int gain;            // "/Spectrum/Gain"
+   int frequencyGain;   // "/Spectrum/FrequencyGain"
+   int windowType;      // "/Spectrum/WindowType"
+   int windowSize;      // "/Spectrum/FFTSize"
+#ifdef EXPERIMENTAL_FFT_SKIP_POINTS
+   int fftSkipPoints;   // "/Spectrum/FFTSkipPoints"
+#endif //EXPERIMENTAL_FFT_SKIP_POINTS
+
+ private:
+   SpectrogramSettings();
+};
+
 class SpectrumPrefs:public PrefsPanel
 {
  public:
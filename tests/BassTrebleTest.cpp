@@ -0,0 +1,219 @@
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/BassTrebleFilter.h"
+
+
+// Bass and Treble's filters as they were before they were run as a biquad
+// cascade: each sample goes through the low shelf and then the high shelf,
+// with the recurrence divided through by a0 every time.
+class OriginalBassTreble
+{
+public:
+   float xn1Bass, xn2Bass, yn1Bass, yn2Bass,
+         a0Bass, a1Bass, a2Bass, b0Bass, b1Bass, b2Bass;
+   float xn1Treble, xn2Treble, yn1Treble, yn2Treble,
+         b0Treble, b1Treble, b2Treble, a0Treble, a1Treble, a2Treble;
+   double mCurRate;
+
+   OriginalBassTreble(double rate, double dB_bass, double dB_treble)
+   {
+      const float slope = 0.4f;   // same slope for both filters
+      const double hzBass = 250.0f;
+      const double hzTreble = 4000.0f;
+
+      mCurRate = rate;
+
+      xn1Bass=xn2Bass=yn1Bass=yn2Bass=0;
+      xn1Treble=xn2Treble=yn1Treble=yn2Treble=0;
+
+      Coefficents(hzBass, slope, dB_bass, 0,
+                  a0Bass, a1Bass, a2Bass,
+                  b0Bass, b1Bass, b2Bass);
+
+      Coefficents(hzTreble, slope, dB_treble, 1,
+                  a0Treble, a1Treble, a2Treble,
+                  b0Treble, b1Treble, b2Treble);
+   }
+
+   void Coefficents(double hz, float slope, double gain, int type,
+                    float& a0, float& a1, float& a2,
+                    float& b0, float& b1, float& b2)
+   {
+      double w = 2 * M_PI * hz / mCurRate;
+      double a = exp(log(10.0) * gain / 40);
+      double b = sqrt((a * a + 1) / slope - (pow((a - 1), 2)));
+
+      if (type == 0)
+      {
+         b0 = a * ((a + 1) - (a - 1) * cos(w) + b * sin(w));
+         b1 = 2 * a * ((a - 1) - (a + 1) * cos(w));
+         b2 = a * ((a + 1) - (a - 1) * cos(w) - b * sin(w));
+         a0 = ((a + 1) + (a - 1) * cos(w) + b * sin(w));
+         a1 = -2 * ((a - 1) + (a + 1) * cos(w));
+         a2 = (a + 1) + (a - 1) * cos(w) - b * sin(w);
+      }
+      else
+      {
+         b0 = a * ((a + 1) + (a - 1) * cos(w) + b * sin(w));
+         b1 = -2 * a * ((a - 1) + (a + 1) * cos(w));
+         b2 = a * ((a + 1) + (a - 1) * cos(w) - b * sin(w));
+         a0 = ((a + 1) - (a - 1) * cos(w) + b * sin(w));
+         a1 = 2 * ((a - 1) - (a + 1) * cos(w));
+         a2 = (a + 1) - (a - 1) * cos(w) - b * sin(w);
+      }
+   }
+
+   float DoFilter(float in)
+   {
+      // Bass filter
+      float out = (b0Bass * in + b1Bass * xn1Bass + b2Bass * xn2Bass -
+            a1Bass * yn1Bass - a2Bass * yn2Bass) / a0Bass;
+      xn2Bass = xn1Bass;
+      xn1Bass = in;
+      yn2Bass = yn1Bass;
+      yn1Bass = out;
+
+      // Treble filter
+      in = out;
+      out = (b0Treble * in + b1Treble * xn1Treble + b2Treble * xn2Treble -
+            a1Treble * yn1Treble - a2Treble * yn2Treble) / a0Treble;
+      xn2Treble = xn1Treble;
+      xn1Treble = in;
+      yn2Treble = yn1Treble;
+      yn1Treble = out;
+
+      return out;
+   }
+};
+
+class BassTrebleTest
+{
+private:
+   enum { kLength = 200000, kMaxBuffer = 5000 };
+   std::vector<float> mInput;
+
+public:
+   BassTrebleTest()
+   {
+      std::cout << "==> Testing Bass and Treble\n";
+   }
+
+   void setUp()
+   {
+      srand(time(NULL));
+
+      // Tones across the range of both shelves, and some noise
+      mInput.resize(kLength);
+      for (int i = 0; i < kLength; i++)
+         mInput[i] = (float)(0.3 * sin(2 * M_PI * 0.002 * i) +
+                             0.2 * sin(2 * M_PI * 0.15 * i) +
+                             0.1 * ((rand() / (float)RAND_MAX) * 2.0f - 1.0f));
+   }
+
+   // Filters mInput in buffers of random length, as the effect is given them
+   std::vector<float> filter(BassTrebleFilter &filter)
+   {
+      std::vector<float> output(mInput);
+      sampleCount pos = 0;
+      while (pos < kLength) {
+         sampleCount len = 1 + rand() % kMaxBuffer;
+         if (len > kLength - pos)
+            len = kLength - pos;
+         filter.Process(&output[pos], len);
+         pos += len;
+      }
+      return output;
+   }
+
+   void testBuffersMatchOneBuffer()
+   {
+      std::cout << "\tfiltering in pieces should match filtering all at once..." << std::flush;
+
+      setUp();
+
+      BassTrebleFilter pieces, whole;
+      pieces.Init(44100, 12, -9);
+      whole.Init(44100, 12, -9);
+
+      std::vector<float> actual = filter(pieces);
+      std::vector<float> expected(mInput);
+      whole.Process(&expected[0], kLength);
+
+      assert(actual == expected);
+
+      std::cout << "ok\n";
+   }
+
+   void testCloseToOriginal()
+   {
+      std::cout << "\tthe biquad cascade should stay close to the original filters..." << std::flush;
+
+      // Not 8000 Hz: there the 4 kHz shelf sits on Nyquist, where its
+      // poles and zeros cancel on the unit circle and any rounding at all
+      // decides the output, before and after alike
+      double rates[] = { 22050, 44100, 96000 };
+      double gains[] = { -30, -12, 0, 12, 30 };
+
+      setUp();
+
+      for (int r = 0; r < 3; r++) {
+         for (int b = 0; b < 5; b++) {
+            for (int t = 0; t < 5; t++) {
+               OriginalBassTreble original(rates[r], gains[b], gains[t]);
+               BassTrebleFilter bassTreble;
+               bassTreble.Init(rates[r], gains[b], gains[t]);
+
+               std::vector<float> actual = filter(bassTreble);
+
+               // The cascade multiplies by coefficients that were divided
+               // through by a0 once, where the original divided every
+               // sample, so only rounding may differ.  The shelves' poles
+               // sit close to the unit circle, which magnifies that.
+               double peak = 0, error = 0;
+               for (int i = 0; i < kLength; i++) {
+                  float expected = original.DoFilter(mInput[i]);
+                  peak = std::max(peak, fabs(expected));
+                  error = std::max(error, fabs(actual[i] - expected));
+               }
+
+               if (error > 1e-3 * peak) {
+                  std::cout << "rate " << rates[r]
+                            << ", bass " << gains[b]
+                            << " dB, treble " << gains[t]
+                            << " dB: error " << error
+                            << " against a peak of " << peak << std::endl;
+                  assert(false);
+               }
+            }
+         }
+      }
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   BassTrebleTest tester;
+
+   tester.testBuffersMatchOneBuffer();
+   tester.testCloseToOriginal();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
@@ -0,0 +1,174 @@
+
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/Biquad.h"
+
+
+class BiquadTest {
+   std::vector<float> mInput;
+   std::vector<BiquadStruct> mStages;
+
+public:
+   BiquadTest()
+   {
+      std::cout << "==> Testing Biquad\n";
+      srand(time(NULL));
+   }
+
+   float Random()
+   {
+      return rand() / (float)RAND_MAX;
+   }
+
+   void setUp(int numStages)
+   {
+      // A few seconds of noise with a tone in it
+      mInput.resize(100000);
+      for (size_t i = 0; i < mInput.size(); i++)
+         mInput[i] = 0.5f * (float)sin(0.01 * i) + 0.5f * (Random() * 2.0f - 1.0f);
+
+      // Stable sections: poles at a random radius under 1, zeros anywhere
+      mStages.resize(numStages);
+      for (int j = 0; j < numStages; j++) {
+         float r = 0.3f + 0.65f * Random();
+         float theta = (float)M_PI * Random();
+         float zr = 1.5f * Random();
+         float ztheta = (float)M_PI * Random();
+         Biquad_SetCoeffs(&mStages[j],
+                          1.0f, -2.0f * zr * cosf(ztheta), zr * zr,
+                          1.0f, -2.0f * r * cosf(theta), r * r);
+         Biquad_Reset(&mStages[j]);
+      }
+   }
+
+   // Each section does the same arithmetic in the same order either way;
+   // allow only for the compiler fusing multiply-adds differently in the
+   // two loops
+   bool Close(float actual, float expected)
+   {
+      return fabsf(actual - expected) <= 1e-5f * (1.0f + fabsf(expected));
+   }
+
+   // What the IIR effects did before the cascade: each section in turn
+   // over the whole buffer, in place
+   void PerStage(std::vector<BiquadStruct> &stages, float *buf, int len)
+   {
+      for (size_t j = 0; j < stages.size(); j++) {
+         stages[j].pfIn = buf;
+         stages[j].pfOut = buf;
+         Biquad_Process(&stages[j], len);
+      }
+   }
+
+   void Cascade(std::vector<BiquadStruct> &stages, float *buf, int len)
+   {
+      std::vector<BiquadStruct *> pointers(stages.size());
+      for (size_t j = 0; j < stages.size(); j++)
+         pointers[j] = &stages[j];
+      Biquad_ProcessCascade(&pointers[0], (int)stages.size(), buf, len);
+   }
+
+   void testCascadeMatchesPerStage()
+   {
+      std::cout << "\tthe cascade should filter like running each section in turn..." << std::flush;
+
+      // Up to more stages than the cascade handles in one go
+      int stageCounts[] = { 1, 2, 5, 8, 9, 17 };
+
+      for (int n = 0; n < 6; n++) {
+         setUp(stageCounts[n]);
+
+         std::vector<BiquadStruct> expectedStages(mStages);
+         std::vector<BiquadStruct> actualStages(mStages);
+         std::vector<float> expected(mInput);
+         std::vector<float> actual(mInput);
+
+         // In buffers of random length, some very short, so the state has
+         // to be carried from one to the next
+         int pos = 0;
+         int len = (int)mInput.size();
+         while (pos < len) {
+            int block = (rand() % 4 == 0) ? 1 + rand() % 3 : 1 + rand() % 5000;
+            if (pos + block > len)
+               block = len - pos;
+            PerStage(expectedStages, &expected[pos], block);
+            Cascade(actualStages, &actual[pos], block);
+            pos += block;
+         }
+
+         for (int i = 0; i < len; i++) {
+            if (!Close(actual[i], expected[i])) {
+               std::cout << stageCounts[n] << " stages: sample " << i
+                         << " is " << actual[i] << ", expected "
+                         << expected[i] << std::endl;
+               assert(false);
+            }
+         }
+
+         // And every section is left in the same state
+         for (int j = 0; j < stageCounts[n]; j++) {
+            assert(Close(actualStages[j].fPrevIn, expectedStages[j].fPrevIn));
+            assert(Close(actualStages[j].fPrevPrevIn, expectedStages[j].fPrevPrevIn));
+            assert(Close(actualStages[j].fPrevOut, expectedStages[j].fPrevOut));
+            assert(Close(actualStages[j].fPrevPrevOut, expectedStages[j].fPrevPrevOut));
+         }
+      }
+
+      std::cout << "ok\n";
+   }
+
+   void testBuffersMatchOneBuffer()
+   {
+      std::cout << "\tfiltering in pieces should match filtering all at once..." << std::flush;
+
+      setUp(6);
+
+      std::vector<BiquadStruct> wholeStages(mStages);
+      std::vector<BiquadStruct> pieceStages(mStages);
+      std::vector<float> whole(mInput);
+      std::vector<float> pieces(mInput);
+
+      Cascade(wholeStages, &whole[0], (int)whole.size());
+
+      int pos = 0;
+      int len = (int)mInput.size();
+      while (pos < len) {
+         int block = 1 + rand() % 3000;
+         if (pos + block > len)
+            block = len - pos;
+         Cascade(pieceStages, &pieces[pos], block);
+         pos += block;
+      }
+
+      // The same sums in the same order, so exactly the same
+      assert(pieces == whole);
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   BiquadTest tester;
+
+   tester.testCascadeMatchesPerStage();
+   tester.testBuffersMatchOneBuffer();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
@@ -0,0 +1,207 @@
+
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/ClickRemover.h"
+
+
+// Click Removal's detector as it was before the window sum was slid along:
+// the ww squared samples are added up afresh at every position.  Records
+// the clicks it repairs the way ClickRemover does.
+class OriginalClickRemover
+{
+public:
+   int sep;
+   int mThresholdLevel;
+   int mClickWidth;
+   std::vector<sampleCount> mClicks;
+
+   OriginalClickRemover(int sep_, int thresholdLevel, int clickWidth)
+   {
+      sep = sep_;
+      mThresholdLevel = thresholdLevel;
+      mClickWidth = clickWidth;
+   }
+
+   bool RemoveClicks(sampleCount len, float *buffer)
+   {
+      bool bResult = false;
+      int i;
+      int j;
+      int left = 0;
+
+      float msw;
+      int ww;
+      int s2 = sep/2;
+      float *ms_seq = new float[len];
+      float *b2 = new float[len];
+
+      mClicks.clear();
+
+      for( i=0; i<len; i++)
+         b2[i] = buffer[i]*buffer[i];
+
+      for(i=0;i<len;i++)
+         ms_seq[i]=b2[i];
+
+      for(i=1; i < sep; i *= 2) {
+         for(j=0;j<len-i; j++)
+            ms_seq[j] += ms_seq[j+i];
+      }
+
+      sep = i;
+
+      for( i=0; i<len-sep; i++ ) {
+         ms_seq[i] /= sep;
+      }
+
+      int wrc;
+      for(wrc=mClickWidth/4; wrc>=1; wrc /= 2) {
+         ww = mClickWidth/wrc;
+
+         for( i=0; i<len-sep; i++ ){
+            msw = 0;
+            for( j=0; j<ww; j++) {
+               msw += b2[i+s2+j];
+            }
+            msw /= ww;
+
+            if(msw >= mThresholdLevel * ms_seq[i]/10) {
+               if( left == 0 ) {
+                  left = i+s2;
+               }
+            } else {
+               if(left != 0 && i-left+s2 <= ww*2) {
+                  float lv = buffer[left];
+                  float rv = buffer[i+ww+s2];
+                  for(j=left; j<i+ww+s2; j++) {
+                     bResult = true;
+                     buffer[j]= (rv*(j-left) + lv*(i+ww+s2-j))/(float)(i+ww+s2-left);
+                     b2[j] = buffer[j]*buffer[j];
+                  }
+                  mClicks.push_back(left);
+                  mClicks.push_back(i+ww+s2);
+                  left=0;
+               } else if(left != 0) {
+                  left = 0;
+               }
+            }
+         }
+      }
+      delete[] ms_seq;
+      delete[] b2;
+      return bResult;
+   }
+};
+
+class ClickRemovalTest {
+   static const int kWindowSize = 8192;
+   static const int kSep = 2049;
+
+   std::vector<float> mWindow;
+
+public:
+   ClickRemovalTest()
+   {
+      std::cout << "==> Testing Click Removal\n";
+      srand(time(NULL));
+   }
+
+   void setUp()
+   {
+      // Quiet music-like background: a couple of tones and some noise
+      mWindow.resize(kWindowSize);
+      double f1 = 0.005 + 0.02 * (rand() / (double)RAND_MAX);
+      double f2 = 0.05 * (rand() / (double)RAND_MAX);
+      for (int i = 0; i < kWindowSize; i++)
+         mWindow[i] = (float)(0.1 * sin(2 * M_PI * f1 * i) +
+                              0.05 * sin(2 * M_PI * f2 * i) +
+                              0.02 * ((rand() / (float)RAND_MAX) * 2.0f - 1.0f));
+
+      // Clicks of random height and width, some too wide to count
+      int numClicks = rand() % 12;
+      for (int c = 0; c < numClicks; c++) {
+         int width = 1 + rand() % 60;
+         int pos = rand() % (kWindowSize - width);
+         float height = 0.2f + 0.8f * (rand() / (float)RAND_MAX);
+         if (rand() % 2)
+            height = -height;
+         for (int i = pos; i < pos + width; i++)
+            mWindow[i] += height * (float)sin(M_PI * (i - pos + 0.5) / width);
+      }
+   }
+
+   void testSlidingSumMatchesOriginal()
+   {
+      std::cout << "\tsliding the window sum should find and repair the same clicks..." << std::flush;
+
+      int thresholds[] = { 50, 200, 500 };
+      int widths[] = { 4, 20, 40 };
+      int windowsWithClicks = 0;
+
+      for (int trial = 0; trial < 50; trial++) {
+         setUp();
+
+         for (int t = 0; t < 3; t++) {
+            for (int w = 0; w < 3; w++) {
+               OriginalClickRemover original(kSep, thresholds[t], widths[w]);
+               ClickRemover remover(kWindowSize, kSep, thresholds[t], widths[w]);
+
+               // Twice over, as the effect does with overlapping windows,
+               // so that sep has been truncated on the second pass
+               std::vector<float> expected(mWindow);
+               std::vector<float> actual(mWindow);
+               for (int pass = 0; pass < 2; pass++) {
+                  bool expectedResult = original.RemoveClicks(kWindowSize, &expected[0]);
+                  bool actualResult = remover.RemoveClicks(kWindowSize, &actual[0]);
+
+                  if (remover.GetClicks() != original.mClicks) {
+                     std::cout << "threshold " << thresholds[t]
+                               << ", width " << widths[w] << ": "
+                               << remover.GetClicks().size() / 2
+                               << " clicks, expected "
+                               << original.mClicks.size() / 2 << std::endl;
+                     assert(false);
+                  }
+                  assert(actualResult == expectedResult);
+                  if (expectedResult)
+                     windowsWithClicks++;
+
+                  // The repairs are computed from the same samples in the
+                  // same way, so they must match exactly
+                  assert(actual == expected);
+               }
+            }
+         }
+      }
+
+      // Make sure the comparison wasn't between two do-nothings
+      assert(windowsWithClicks > 0);
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   ClickRemovalTest tester;
+
+   tester.testSlidingSumMatchesOriginal();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
@@ -0,0 +1,148 @@
+
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/ClippingRunDetector.h"
+
+
+struct ClippingRun {
+   sampleCount start;
+   sampleCount end;
+   sampleCount clipped;
+   sampleCount samples;
+
+   bool operator==(const ClippingRun &other) const
+   {
+      return start == other.start && end == other.end &&
+             clipped == other.clipped && samples == other.samples;
+   }
+};
+
+class FindClippingTest {
+   std::vector<bool> mClipped;
+
+public:
+   FindClippingTest()
+   {
+      std::cout << "==> Testing FindClipping\n";
+      srand(time(NULL));
+   }
+
+   void setUp(sampleCount len)
+   {
+      // Bursts of clipping of random length, some shorter than the
+      // start threshold, separated by clean stretches of random length,
+      // some shorter than the stop threshold
+      mClipped.assign(len, false);
+      sampleCount s = rand() % 50;
+      while (s < len) {
+         sampleCount burst = 1 + rand() % 8;
+         for (sampleCount i = 0; i < burst && s < len; i++, s++) {
+            // An odd unclipped sample inside a burst
+            mClipped[s] = (rand() % 10 != 0);
+         }
+         s += 1 + rand() % ((rand() % 4 == 0) ? 2000 : 12);
+      }
+   }
+
+   void Add(std::vector<ClippingRun> &runs, const ClippingRunDetector &detector)
+   {
+      ClippingRun run;
+      run.start = detector.GetRunStart();
+      run.end = detector.GetRunEnd();
+      run.clipped = detector.GetRunClipped();
+      run.samples = detector.GetRunSamples();
+      runs.push_back(run);
+   }
+
+   // What Find Clipping used to do: look at every sample
+   std::vector<ClippingRun> EverySample(int start, int stop)
+   {
+      std::vector<ClippingRun> runs;
+      ClippingRunDetector detector(start, stop);
+      for (sampleCount s = 0; s < (sampleCount)mClipped.size(); s++)
+         if (detector.Sample(mClipped[s], s))
+            Add(runs, detector);
+      return runs;
+   }
+
+   // What it does now: skip spans whose peak says they have no clipping
+   std::vector<ClippingRun> SkippingSpans(int start, int stop, sampleCount span)
+   {
+      std::vector<ClippingRun> runs;
+      ClippingRunDetector detector(start, stop);
+      sampleCount len = mClipped.size();
+      for (sampleCount s = 0; s < len; s += span) {
+         sampleCount n = (s + span > len) ? len - s : span;
+         bool any = false;
+         for (sampleCount i = s; i < s + n; i++)
+            any = any || mClipped[i];
+
+         if (!any) {
+            if (detector.SkipUnclipped(s, n))
+               Add(runs, detector);
+         }
+         else {
+            for (sampleCount i = s; i < s + n; i++)
+               if (detector.Sample(mClipped[i], i))
+                  Add(runs, detector);
+         }
+      }
+      return runs;
+   }
+
+   void testSkipMatchesEverySample()
+   {
+      std::cout << "\tskipping unclipped spans should find the same runs as reading every sample..." << std::flush;
+
+      int thresholds[][2] = { {1, 1}, {3, 3}, {2, 7}, {5, 1}, {1, 40} };
+      sampleCount spans[] = { 1, 3, 16, 257, 1024 };
+
+      for (int trial = 0; trial < 20; trial++) {
+         setUp(20000);
+         for (int t = 0; t < 5; t++) {
+            int start = thresholds[t][0];
+            int stop = thresholds[t][1];
+            std::vector<ClippingRun> expected = EverySample(start, stop);
+            assert(!expected.empty());
+
+            for (int sp = 0; sp < 5; sp++) {
+               std::vector<ClippingRun> actual =
+                  SkippingSpans(start, stop, spans[sp]);
+               if (!(actual == expected)) {
+                  std::cout << "start=" << start << " stop=" << stop
+                            << " span=" << spans[sp] << ": "
+                            << actual.size() << " runs, expected "
+                            << expected.size() << std::endl;
+                  assert(false);
+               }
+            }
+         }
+      }
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   FindClippingTest tester;
+
+   tester.testSkipMatchesEverySample();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
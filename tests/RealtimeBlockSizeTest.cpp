@@ -0,0 +1,222 @@
+
+#include <algorithm>
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/RealtimeRuns.h"
+
+
+// A realtime client that runs a one-pole low-pass filter, so its output
+// depends on state carried from one run to the next.  It takes runs of at
+// most mMaxBlockSize samples and counts how many it was given.
+class FilterClient : public EffectClientInterface {
+   sampleCount mMaxBlockSize;
+   std::vector<float> mState;
+
+public:
+   sampleCount mBlockSize;
+   long mRuns;
+
+   FilterClient(sampleCount maxBlockSize)
+   {
+      mMaxBlockSize = maxBlockSize;
+      mBlockSize = 0;
+      mRuns = 0;
+   }
+
+   // IdentInterface
+   virtual wxString GetPath() { return wxT("FilterClient"); }
+   virtual wxString GetSymbol() { return wxT("FilterClient"); }
+   virtual wxString GetName() { return wxT("FilterClient"); }
+   virtual wxString GetVendor() { return wxEmptyString; }
+   virtual wxString GetVersion() { return wxEmptyString; }
+   virtual wxString GetDescription() { return wxEmptyString; }
+
+   // EffectIdentInterface
+   virtual EffectType GetType() { return EffectTypeProcess; }
+   virtual wxString GetFamily() { return wxEmptyString; }
+   virtual bool IsInteractive() { return false; }
+   virtual bool IsDefault() { return false; }
+   virtual bool IsLegacy() { return false; }
+   virtual bool SupportsRealtime() { return true; }
+   virtual bool SupportsAutomation() { return false; }
+
+   // EffectClientInterface
+   virtual bool SetHost(EffectHostInterface *) { return true; }
+   virtual int GetAudioInCount() { return 1; }
+   virtual int GetAudioOutCount() { return 1; }
+   virtual int GetMidiInCount() { return 0; }
+   virtual int GetMidiOutCount() { return 0; }
+   virtual void SetSampleRate(sampleCount) {}
+
+   virtual sampleCount GetBlockSize(sampleCount maxBlockSize)
+   {
+      mBlockSize = (maxBlockSize < mMaxBlockSize) ? maxBlockSize : mMaxBlockSize;
+      return mBlockSize;
+   }
+
+   virtual sampleCount GetLatency() { return 0; }
+   virtual sampleCount GetTailSize() { return 0; }
+   virtual bool IsReady() { return true; }
+   virtual bool ProcessInitialize() { return true; }
+   virtual bool ProcessFinalize() { return true; }
+   virtual sampleCount ProcessBlock(float **, float **, sampleCount size) { return size; }
+
+   virtual bool RealtimeInitialize() { mState.clear(); return true; }
+
+   virtual bool RealtimeAddProcessor(int, float)
+   {
+      mState.push_back(0.0f);
+      return true;
+   }
+
+   virtual bool RealtimeFinalize() { mState.clear(); return true; }
+   virtual bool RealtimeSuspend() { return true; }
+   virtual bool RealtimeResume() { return true; }
+   virtual bool RealtimeProcessStart() { return true; }
+
+   virtual sampleCount RealtimeProcess(int group, float **inbuf, float **outbuf,
+                                       sampleCount numSamples)
+   {
+      // Each run must fit in the block size we agreed to
+      assert(numSamples <= mBlockSize);
+
+      float y = mState[group];
+      for (sampleCount i = 0; i < numSamples; i++)
+      {
+         y += 0.1f * (inbuf[0][i] - y);
+         outbuf[0][i] = y;
+      }
+      mState[group] = y;
+
+      mRuns++;
+      return numSamples;
+   }
+
+   virtual bool RealtimeProcessEnd() { return true; }
+
+   virtual bool ShowInterface(wxWindow *, bool) { return false; }
+   virtual bool GetAutomationParameters(EffectAutomationParameters &) { return true; }
+   virtual bool SetAutomationParameters(EffectAutomationParameters &) { return true; }
+};
+
+class RealtimeBlockSizeTest {
+   std::vector<float> mInput;
+
+public:
+   RealtimeBlockSizeTest()
+   {
+      std::cout << "==> Testing realtime effect block sizes\n";
+      srand(time(NULL));
+   }
+
+   void setUp()
+   {
+      // Ten seconds of noise at 44.1kHz
+      mInput.resize(441000);
+      for (size_t i = 0; i < mInput.size(); i++)
+         mInput[i] = (rand() / (float)RAND_MAX) * 2.0f - 1.0f;
+   }
+
+   // Feed the input through a client the way Effect::RealtimeProcess()
+   // does, one buffer at a time
+   void Run(FilterClient &client, sampleCount bufferSize,
+            std::vector<float> &output)
+   {
+      sampleCount blockSize = client.GetBlockSize(REALTIME_MAX_BLOCK_SIZE);
+      client.RealtimeInitialize();
+      client.RealtimeAddProcessor(1, 44100.0);
+
+      output.resize(mInput.size());
+      std::vector<float> buffer(bufferSize);
+      std::vector<float> scratch(bufferSize);
+
+      for (size_t pos = 0; pos < mInput.size(); pos += bufferSize)
+      {
+         sampleCount len = bufferSize;
+         if (pos + len > mInput.size())
+            len = mInput.size() - pos;
+
+         std::copy(mInput.begin() + pos, mInput.begin() + pos + len,
+                   buffer.begin());
+
+         float *inbuf[1] = { &buffer[0] };
+         float *outbuf[1] = { &scratch[0] };
+         client.RealtimeProcessStart();
+         sampleCount done = RealtimeProcessRuns(&client, 0, inbuf, 1,
+                                                outbuf, 1, len, blockSize);
+         assert(done == len);
+         client.RealtimeProcessEnd();
+
+         std::copy(scratch.begin(), scratch.begin() + len,
+                   output.begin() + pos);
+      }
+
+      client.RealtimeFinalize();
+   }
+
+   void testLargeRunsMatchSmallRuns()
+   {
+      std::cout << "\tlarge runs should give the same output as 512 sample runs, in fewer calls..." << std::flush;
+
+      sampleCount bufferSizes[] = { 256, 1000, 2048, 4096, 8192 };
+      std::vector<float> expected;
+      std::vector<float> actual;
+
+      for (int b = 0; b < 5; b++)
+      {
+         sampleCount bufferSize = bufferSizes[b];
+
+         // What realtime effects were offered before
+         FilterClient oldClient(512);
+         Run(oldClient, bufferSize, expected);
+         assert(oldClient.mBlockSize == 512);
+
+         // What they're offered now
+         FilterClient newClient(REALTIME_MAX_BLOCK_SIZE * 2);
+         Run(newClient, bufferSize, actual);
+         assert(newClient.mBlockSize == REALTIME_MAX_BLOCK_SIZE);
+
+         assert(actual == expected);
+
+         // Whole device buffers go over in one run, unless they are bigger
+         // than the largest run on offer
+         long runs = 0;
+         for (size_t pos = 0; pos < mInput.size(); pos += bufferSize)
+         {
+            sampleCount len = bufferSize;
+            if (pos + len > mInput.size())
+               len = mInput.size() - pos;
+            runs += (len + REALTIME_MAX_BLOCK_SIZE - 1) / REALTIME_MAX_BLOCK_SIZE;
+         }
+         assert(newClient.mRuns == runs);
+         assert(newClient.mRuns <= oldClient.mRuns);
+      }
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   RealtimeBlockSizeTest tester;
+
+   tester.setUp();
+   tester.testLargeRunsMatchSmallRuns();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
@@ -0,0 +1,167 @@
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/Reverb_libSoX.h"
+
+
+// The filter bank as it was before it was run a block at a time: every
+// sample goes through all eight combs and four allpasses in turn.
+static float original_comb_process(filter_t * p,
+      float const * input, float const * feedback, float const * hf_damping)
+{
+   float output = *p->ptr;
+   p->store = output + (p->store - output) * *hf_damping;
+   *p->ptr = *input + p->store * *feedback;
+   filter_advance(p);
+   return output;
+}
+
+static float original_allpass_process(filter_t * p, float const * input)
+{
+   float output = *p->ptr;
+   *p->ptr = *input + output * .5;
+   filter_advance(p);
+   return output - *input;
+}
+
+static void original_filter_array_process(filter_array_t * p,
+      size_t length, float const * input, float * output,
+      float const * feedback, float const * hf_damping, float const * gain)
+{
+   while (length--) {
+      float out = 0, in = *input++;
+
+      size_t i = array_length(comb_lengths) - 1;
+      do out += original_comb_process(p->comb + i, &in, feedback, hf_damping);
+      while (i--);
+
+      i = array_length(allpass_lengths) - 1;
+      do out = original_allpass_process(p->allpass + i, &out);
+      while (i--);
+
+      out = one_pole_process(&p->one_pole[0], out);
+      out = one_pole_process(&p->one_pole[1], out);
+      *output++ = out * *gain;
+   }
+}
+
+static void original_reverb_process(reverb_t * p, size_t length)
+{
+   size_t i;
+   for (i = 0; i < 2 && p->out[i]; ++i)
+      original_filter_array_process(p->chan + i, length, (float *) fifo_read_ptr(&p->input_fifo), p->out[i], &p->feedback, &p->hf_damping, &p->gain);
+   fifo_read(&p->input_fifo, length, NULL);
+}
+
+class ReverbTest
+{
+private:
+   enum { kBlockSize = 0x4000, kLength = 100000 };
+   std::vector<float> mInput;
+
+public:
+   ReverbTest()
+   {
+      std::cout << "==> Testing Reverb\n";
+   }
+
+   void setUp()
+   {
+      srand(time(NULL));
+
+      mInput.resize(kLength);
+      for (int i = 0; i < kLength; i++)
+         mInput[i] = (float)(0.5 * sin(2 * M_PI * 0.01 * i) +
+                             0.3 * ((rand() / (float)RAND_MAX) * 2.0f - 1.0f));
+   }
+
+   void testBlockFiltersMatchOriginal()
+   {
+      std::cout << "\trunning each filter over the whole block should not change the output..." << std::flush;
+
+      double rates[] = { 8000, 44100, 96000 };
+      double roomSizes[] = { 0, 75, 100 };
+      double widths[] = { 0, 50, 100 };
+
+      setUp();
+
+      bool heard = false;
+      for (int r = 0; r < 3; r++) {
+         for (int s = 0; s < 3; s++) {
+            for (int w = 0; w < 3; w++) {
+               reverb_t actual, expected;
+               float * actualOut[2] = { 0, 0 };
+               float * expectedOut[2] = { 0, 0 };
+
+               reverb_create(&actual, rates[r], -1, roomSizes[s], 50, 50,
+                             10, widths[w], 100, 100, kBlockSize, actualOut);
+               reverb_create(&expected, rates[r], -1, roomSizes[s], 50, 50,
+                             10, widths[w], 100, 100, kBlockSize, expectedOut);
+
+               // Blocks of all sizes, so that the filters' state is carried
+               // over from one block to the next at every point in the delay
+               // lines, not just at the same few
+               size_t pos = 0;
+               while (pos < kLength) {
+                  size_t len = std::min((size_t)(1 + rand() % kBlockSize),
+                                        (size_t)(kLength - pos));
+                  fifo_write(&actual.input_fifo, len, &mInput[pos]);
+                  fifo_write(&expected.input_fifo, len, &mInput[pos]);
+                  reverb_process(&actual, len);
+                  original_reverb_process(&expected, len);
+
+                  for (int c = 0; c < 2 && expectedOut[c]; c++) {
+                     assert(actualOut[c] != 0);
+                     for (size_t i = 0; i < len; i++) {
+                        if (actualOut[c][i] != expectedOut[c][i]) {
+                           std::cout << "rate " << rates[r]
+                                     << ", room size " << roomSizes[s]
+                                     << ", width " << widths[w]
+                                     << ": channel " << c
+                                     << " differs at sample " << pos + i
+                                     << std::endl;
+                           assert(false);
+                        }
+                        if (expectedOut[c][i] != 0)
+                           heard = true;
+                     }
+                  }
+                  pos += len;
+               }
+
+               reverb_delete(&actual);
+               reverb_delete(&expected);
+            }
+         }
+      }
+
+      // Make sure the comparison wasn't between two silences
+      assert(heard);
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   ReverbTest tester;
+
+   tester.testBlockFiltersMatchOriginal();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
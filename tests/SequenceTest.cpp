@@ -1,9 +1,11 @@
 
 #include "Sequence.h"
 #include "DirManager.h"
+#include "BlockFile.h"
 #include <wx/hash.h>
 #include <vector>
 #include <iostream>
+#include <cmath>
 
 class SequenceTest
 {
@@ -131,6 +133,168 @@ public:
       std::cout << "ok\n";
    }
 
+   void CheckStatistics(const char *when)
+   {
+      for(int i = 0; i < 100; i++)
+      {
+         sampleCount start = rand()%mMemorySequence.size();
+         sampleCount len = 1 + rand()%(mMemorySequence.size() - start);
+         if (i == 0) {
+            start = 0;
+            len = mMemorySequence.size();
+         }
+
+         double sum = 0, sumsq = 0;
+         float min = mMemorySequence[start], max = min;
+         for(sampleCount j = start; j < start + len; j++) {
+            float sample = mMemorySequence[j];
+            sum += sample;
+            sumsq += sample * sample;
+            if (sample < min)
+               min = sample;
+            if (sample > max)
+               max = sample;
+         }
+
+         SampleStats stats;
+         assert(mSequence->GetStatistics(start, len, &stats));
+
+         if (stats.count != len || stats.min != min || stats.max != max ||
+             fabs(stats.sum - sum) > 1e-9 * len ||
+             fabs(stats.sumsq - sumsq) > 1e-9 * len) {
+            std::cout << when << ": start=" << start << " len=" << len
+                      << " sum " << stats.sum << " != " << sum << std::endl;
+            assert(false);
+         }
+      }
+   }
+
+   void TestGetStatistics()
+   {
+      std::cout << "\tSequence::GetStatistics() should match a sum over the samples, across blocks and after edits..." << std::flush;
+
+      // Small blocks, so that ranges span many of them
+      int oldMaxDiskBlockSize = Sequence::GetMaxDiskBlockSize();
+      Sequence::SetMaxDiskBlockSize(4096);
+      delete mSequence;
+      mSequence = new Sequence(mDirManager, floatSample);
+
+      int appendBufLen = (int)(mSequence->GetMaxBlockSize() * 1.4);
+      float *appendBuf = new float[appendBufLen];
+      int i;
+
+      for(i = 0; i < 20; i++)
+      {
+         for(int j = 0; j < appendBufLen; j++) {
+            appendBuf[j] = (rand() % 20001 - 10000) / 10000.0f;
+            mMemorySequence.push_back(appendBuf[j]);
+         }
+         mSequence->Append((samplePtr)appendBuf, floatSample, appendBufLen);
+      }
+      CheckStatistics("after append");
+
+      for(i = 0; i < 10; i++)
+      {
+         /* set, which keeps the statistics of untouched blocks */
+         sampleCount s0 = rand()%mMemorySequence.size();
+         sampleCount len = rand()%(mMemorySequence.size() - s0);
+         if (len > appendBufLen)
+            len = appendBufLen;
+         for(int j = 0; j < len; j++) {
+            appendBuf[j] = (rand() % 20001 - 10000) / 10000.0f;
+            mMemorySequence[s0 + j] = appendBuf[j];
+         }
+         assert(mSequence->Set((samplePtr)appendBuf, floatSample, s0, len));
+         CheckStatistics("after set");
+
+         /* copy/paste */
+         Sequence *tmpSequence;
+         s0 = rand()%mMemorySequence.size();
+         len = rand()%(mMemorySequence.size() - s0);
+         mSequence->Copy(s0, s0+len, &tmpSequence);
+         sampleCount dest = rand()%mMemorySequence.size();
+         mSequence->Paste(dest, tmpSequence);
+         delete tmpSequence;
+         std::vector<float> pasted(mMemorySequence.begin() + s0,
+                                   mMemorySequence.begin() + s0 + len);
+         mMemorySequence.insert(mMemorySequence.begin() + dest,
+                                pasted.begin(), pasted.end());
+         CheckStatistics("after paste");
+
+         /* delete */
+         sampleCount del = rand()%mMemorySequence.size();
+         sampleCount dellen = rand()%((mMemorySequence.size()-del)/2);
+         mSequence->Delete(del, dellen);
+         mMemorySequence.erase(mMemorySequence.begin() + del,
+                               mMemorySequence.begin() + del + dellen);
+         CheckStatistics("after delete");
+      }
+
+      assert(mSequence->GetNumSamples() == (sampleCount)mMemorySequence.size());
+
+      delete [] appendBuf;
+      Sequence::SetMaxDiskBlockSize(oldMaxDiskBlockSize);
+
+      std::cout << "ok\n";
+   }
+
+   void TestGetContentKey()
+   {
+      std::cout << "\tSequence::GetContentKey() should follow the audio through edits elsewhere..." << std::flush;
+
+      // Small blocks, so that an edit touches only a few of many
+      int oldMaxDiskBlockSize = Sequence::GetMaxDiskBlockSize();
+      Sequence::SetMaxDiskBlockSize(4096);
+      delete mSequence;
+      mSequence = new Sequence(mDirManager, floatSample);
+
+      int appendBufLen = (int)(mSequence->GetMaxBlockSize() * 1.4);
+      float *appendBuf = new float[appendBufLen];
+      int i;
+
+      for(i = 0; i < 20; i++)
+      {
+         for(int j = 0; j < appendBufLen; j++)
+            appendBuf[j] = (rand() % 20001 - 10000) / 10000.0f;
+         mSequence->Append((samplePtr)appendBuf, floatSample, appendBufLen);
+      }
+
+      // A range near the end, likely to straddle a block boundary
+      sampleCount len = mSequence->GetMaxBlockSize();
+      sampleCount start = mSequence->GetNumSamples() - 3 * len;
+      std::vector<sampleCount> before, after;
+      assert(mSequence->GetContentKey(start, len, before));
+
+      /* set, well before the range */
+      assert(mSequence->Set((samplePtr)appendBuf, floatSample, 0, 100));
+      assert(mSequence->GetContentKey(start, len, after));
+      assert(after == before);
+
+      /* delete, well before the range, which moves it */
+      assert(mSequence->Delete(0, 100));
+      after.clear();
+      assert(mSequence->GetContentKey(start - 100, len, after));
+      assert(after == before);
+
+      /* set, inside the range */
+      assert(mSequence->Set((samplePtr)appendBuf, floatSample,
+                            start - 100 + len / 2, 1));
+      after.clear();
+      assert(mSequence->GetContentKey(start - 100, len, after));
+      assert(after != before);
+
+      /* ranges that aren't all there */
+      after.clear();
+      assert(!mSequence->GetContentKey(mSequence->GetNumSamples() - 10, 20,
+                                       after));
+      assert(!mSequence->GetContentKey(-10, 20, after));
+
+      delete [] appendBuf;
+      Sequence::SetMaxDiskBlockSize(oldMaxDiskBlockSize);
+
+      std::cout << "ok\n";
+   }
+
 };
 
 int main()
@@ -149,6 +313,14 @@ int main()
    tester.TestGetGarbageInput();
    tester.TearDown();
 
+   tester.SetUp();
+   tester.TestGetStatistics();
+   tester.TearDown();
+
+   tester.SetUp();
+   tester.TestGetContentKey();
+   tester.TearDown();
+
    return 0;
 }
 
@@ -2,6 +2,9 @@
 #include <iostream>
 #include <ostream>
 #include <cassert>
+#include <cfloat>
+#include <cmath>
+#include <cstdlib>
 
 #include "sndfile.h"
 #include "blockfile/SimpleBlockFile.h"
@@ -186,6 +189,65 @@ public:
 
        std::cout << "OK\n";
    }
+
+   void testGetMinMax() {
+      // GetMinMax(start, len) answers whole 256-sample frames from the
+      // summary and reads the rest; check it against the samples over
+      // ranges that start and end off the frame grid
+      std::cout << "\tVerifying GetMinMax over partial ranges against the samples..." << std::flush;
+
+      BlockFile *theFiles[] = {int16BlockFile, floatBlockFile};
+      float *samples = new float[dataLen];
+
+      for(int f = 0; f < 2; f++)
+      {
+         BlockFile *bf = theFiles[f];
+         bf->ReadData((samplePtr)samples, floatSample, 0, dataLen);
+
+         for(int trial = 0; trial < 200; trial++)
+         {
+            int start, len;
+            if (trial < 4) {
+               // Edge cases: tiny ranges, a single frame, the whole
+               // block and the short last frame
+               int starts[] = {0, 255, 256, dataLen - 300};
+               int lens[] = {1, 2, 256, 300};
+               start = starts[trial];
+               len = lens[trial];
+            }
+            else {
+               start = rand() % dataLen;
+               len = 1 + rand() % (dataLen - start);
+            }
+
+            float min = FLT_MAX, max = -FLT_MAX;
+            double sumsq = 0;
+            for(int i = start; i < start + len; i++) {
+               if (samples[i] < min)
+                  min = samples[i];
+               if (samples[i] > max)
+                  max = samples[i];
+               sumsq += samples[i] * samples[i];
+            }
+            float rms = sqrt(sumsq / len);
+
+            float bfMin, bfMax, bfRMS;
+            bf->GetMinMax(start, len, &bfMin, &bfMax, &bfRMS);
+
+            if (bfMin != min || bfMax != max ||
+                fabs(bfRMS - rms) > 1e-4 * rms + 1e-7) {
+               std::cout << "start=" << start << " len=" << len << ": "
+                         << bfMin << " " << bfMax << " " << bfRMS << " != "
+                         << min << " " << max << " " << rms << std::endl;
+               assert(false);
+            }
+         }
+      }
+
+      delete [] samples;
+
+      std::cout << "OK\n";
+   }
 };
 
 int main()
@@ -204,6 +266,10 @@ int main()
     tester.testReads();
     tester.tearDown();
 
+    tester.setUp();
+    tester.testGetMinMax();
+    tester.tearDown();
+
     return 0;
 }
 
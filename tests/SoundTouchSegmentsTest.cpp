@@ -0,0 +1,193 @@
+
+#include <algorithm>
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <vector>
+
+#include "effects/SoundTouchSegments.h"
+
+#if USE_SOUNDTOUCH
+
+using namespace soundtouch;
+
+class SoundTouchSegmentsTest {
+   static const int kRate = 44100;
+   static const int kChannels = 2;
+
+   std::vector<float> mInput;  // interleaved
+
+public:
+   SoundTouchSegmentsTest()
+   {
+      std::cout << "==> Testing SoundTouch segments\n";
+   }
+
+   void setUp()
+   {
+      // Eight seconds of a stereo tone with a few harmonics, some vibrato
+      // and a slowly changing level, so that a misplaced or badly faded
+      // splice changes the output noticeably
+      sampleCount len = 8 * kRate;
+      mInput.resize(len * kChannels);
+      double phase = 0.0;
+      for (sampleCount i = 0; i < len; i++) {
+         double t = i / (double)kRate;
+         phase += 2 * M_PI * 220.0 * (1.0 + 0.01 * sin(2 * M_PI * 5.0 * t)) / kRate;
+         double level = 0.3 + 0.2 * sin(2 * M_PI * 0.3 * t);
+         double x = level * (sin(phase) + 0.5 * sin(2 * phase) + 0.25 * sin(3 * phase));
+         mInput[i * kChannels] = (float)x;
+         mInput[i * kChannels + 1] = (float)(0.8 * x + 0.1 * level * sin(5 * phase));
+      }
+   }
+
+   SoundTouch *NewSoundTouch(double tempo, double semitones)
+   {
+      SoundTouch *soundTouch = new SoundTouch();
+      soundTouch->setTempo((float)tempo);
+      soundTouch->setPitchSemiTones((float)semitones);
+      soundTouch->setChannels(kChannels);
+      soundTouch->setSampleRate(kRate);
+      return soundTouch;
+   }
+
+   // The whole input through one SoundTouch, as the serial path does it
+   std::vector<float> Serial(double tempo, double semitones)
+   {
+      SoundTouchSegment segment;
+      segment.inStart = 0;
+      segment.inEnd = (sampleCount)(mInput.size() / kChannels);
+      segment.numChannels = kChannels;
+      segment.input = new float[mInput.size()];
+      std::copy(mInput.begin(), mInput.end(), segment.input);
+      segment.soundTouch = NewSoundTouch(tempo, semitones);
+      segment.Stretch();
+      return segment.output;
+   }
+
+   // Cut into segments of segmentSecs, stretched separately and spliced
+   std::vector<float> Segmented(double tempo, double semitones, double segmentSecs)
+   {
+      double ratio = 1.0 / tempo;
+      sampleCount len = (sampleCount)(mInput.size() / kChannels);
+      sampleCount segmentLen = (sampleCount)(segmentSecs * kRate);
+
+      std::vector<sampleCount> cuts;
+      cuts.push_back(0);
+      for (sampleCount pos = segmentLen; pos + segmentLen <= len; pos += segmentLen)
+         cuts.push_back(pos);
+      cuts.push_back(len);
+
+      SoundTouchSplicer splicer(kChannels,
+                                (sampleCount)(SEGMENT_ALIGN_SECONDS * kRate * ratio));
+      std::vector<float> result;
+
+      for (int k = 0; k + 1 < (int)cuts.size(); k++) {
+         SoundTouchSegment segment;
+         segment.Place(cuts, k,
+                       (sampleCount)(SEGMENT_OVERLAP_SECONDS * kRate),
+                       (sampleCount)(SEGMENT_PREROLL_SECONDS * kRate), ratio);
+         segment.numChannels = kChannels;
+         segment.input = new float[(segment.inEnd - segment.inStart) * kChannels];
+         std::copy(mInput.begin() + segment.inStart * kChannels,
+                   mInput.begin() + segment.inEnd * kChannels,
+                   segment.input);
+         segment.soundTouch = NewSoundTouch(tempo, semitones);
+         segment.Stretch();
+
+         bool ok = splicer.Splice(segment, result);
+         assert(ok);
+      }
+
+      return result;
+   }
+
+   // RMS of one channel over frames [start, start + len)
+   double RMS(const std::vector<float> &x, sampleCount start, sampleCount len)
+   {
+      double sum = 0.0;
+      for (sampleCount i = start; i < start + len; i++)
+         sum += x[i * kChannels] * x[i * kChannels];
+      return sqrt(sum / len);
+   }
+
+   void Compare(double tempo, double semitones)
+   {
+      std::vector<float> expected = Serial(tempo, semitones);
+      std::vector<float> actual = Segmented(tempo, semitones, 1.5);
+
+      sampleCount expectedLen = (sampleCount)(expected.size() / kChannels);
+      sampleCount actualLen = (sampleCount)(actual.size() / kChannels);
+
+      // About as long as the serial output: each splice may move things by
+      // no more than the alignment search
+      sampleCount slack = (sampleCount)(5 * SEGMENT_ALIGN_SECONDS * kRate / tempo);
+      assert(actualLen > expectedLen - slack && actualLen < expectedLen + slack);
+
+      // Up to the first splice, the first segment did just what the serial
+      // SoundTouch did
+      sampleCount firstFade =
+         (sampleCount)((1.5 - SEGMENT_OVERLAP_SECONDS) * kRate / tempo);
+      for (sampleCount i = 0; i < firstFade * kChannels; i++)
+         assert(actual[i] == expected[i]);
+
+      // Everywhere else the level follows the serial output's closely, with
+      // no dropouts or dips at the splices.  The last 50ms is left out, since
+      // the two may end a few milliseconds apart.
+      sampleCount frame = kRate / 100;
+      sampleCount last = std::min(expectedLen, actualLen) - kRate / 20;
+      for (sampleCount f = 0; f + frame <= last; f += frame) {
+         double e = RMS(expected, f, frame);
+         double a = RMS(actual, f, frame);
+         double db = 20.0 * log10(a / e);
+         if (fabs(db) > 1.0) {
+            std::cout << "tempo " << tempo << ", " << semitones
+                      << " semitones: level differs by " << db
+                      << " dB at " << f / (double)kRate << "s" << std::endl;
+            assert(false);
+         }
+      }
+   }
+
+   void testSegmentsMatchSerial()
+   {
+      std::cout << "\tsegmented stretching should sound like stretching it all at once..." << std::flush;
+
+      Compare(1.5, 0.0);
+      Compare(0.7, 0.0);
+      Compare(1.0, 5.0);
+      Compare(1.25, -3.0);
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   SoundTouchSegmentsTest tester;
+
+   tester.setUp();
+   tester.testSegmentsMatchSerial();
+
+   return 0;
+}
+
+#else
+
+int main()
+{
+   return 0;
+}
+
+#endif
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3
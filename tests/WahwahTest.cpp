@@ -0,0 +1,215 @@
+#include <iostream>
+#include <ostream>
+#include <cassert>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#include "effects/WahwahFilter.h"
+
+
+// Wahwah's filter as it was before it was run through Biquad_Process: the
+// LFO is checked at every sample and the recurrence is divided through by
+// a0 every time.
+class OriginalWahwah
+{
+public:
+   float phase;
+   float lfoskip;
+   unsigned long skipcount;
+   float xn1, xn2, yn1, yn2;
+   float b0, b1, b2, a0, a1, a2;
+   float depth, freqofs, res;
+
+   OriginalWahwah(double rate, float freq, float phase_,
+                  float depth_, float freqofs_, float res_)
+   {
+      lfoskip = freq * 2 * M_PI / rate;
+      skipcount = 0;
+      xn1 = 0;
+      xn2 = 0;
+      yn1 = 0;
+      yn2 = 0;
+      b0 = 0;
+      b1 = 0;
+      b2 = 0;
+      a0 = 0;
+      a1 = 0;
+      a2 = 0;
+
+      phase = phase_;
+      depth = depth_;
+      freqofs = freqofs_;
+      res = res_;
+   }
+
+   void Process(float *buffer, sampleCount len)
+   {
+      float frequency, omega, sn, cs, alpha;
+      float in, out;
+
+      for (int i = 0; i < len; i++) {
+         in = buffer[i];
+
+         if ((skipcount++) % 30 == 0) {
+            frequency = (1 + cos(skipcount * lfoskip + phase)) / 2;
+            frequency = frequency * depth * (1 - freqofs) + freqofs;
+            frequency = exp((frequency - 1) * 6);
+            omega = M_PI * frequency;
+            sn = sin(omega);
+            cs = cos(omega);
+            alpha = sn / (2 * res);
+            b0 = (1 - cs) / 2;
+            b1 = 1 - cs;
+            b2 = (1 - cs) / 2;
+            a0 = 1 + alpha;
+            a1 = -2 * cs;
+            a2 = 1 - alpha;
+         };
+         out = (b0 * in + b1 * xn1 + b2 * xn2 - a1 * yn1 - a2 * yn2) / a0;
+         xn2 = xn1;
+         xn1 = in;
+         yn2 = yn1;
+         yn1 = out;
+
+         buffer[i] = (float) out;
+      }
+   }
+};
+
+class WahwahTest
+{
+private:
+   enum { kLength = 200000, kMaxBuffer = 5000 };
+   std::vector<float> mInput;
+
+public:
+   WahwahTest()
+   {
+      std::cout << "==> Testing Wahwah\n";
+   }
+
+   void setUp()
+   {
+      srand(time(NULL));
+
+      mInput.resize(kLength);
+      for (int i = 0; i < kLength; i++)
+         mInput[i] = (float)(0.3 * sin(2 * M_PI * 0.01 * i) +
+                             0.2 * ((rand() / (float)RAND_MAX) * 2.0f - 1.0f));
+   }
+
+   // Filters mInput in buffers of random length, as the effect is given them
+   template <class Filter>
+   std::vector<float> filter(Filter &filter)
+   {
+      std::vector<float> output(mInput);
+      sampleCount pos = 0;
+      while (pos < kLength) {
+         sampleCount len = 1 + rand() % kMaxBuffer;
+         if (len > kLength - pos)
+            len = kLength - pos;
+         filter.Process(&output[pos], len);
+         pos += len;
+      }
+      return output;
+   }
+
+   void testBuffersMatchOneBuffer()
+   {
+      std::cout << "\tfiltering in pieces should match filtering all at once..." << std::flush;
+
+      setUp();
+
+      WahwahFilter pieces, whole;
+      pieces.Init(44100, 1.5f, 0, 0.7f, 0.3f, 2.5f);
+      whole.Init(44100, 1.5f, 0, 0.7f, 0.3f, 2.5f);
+
+      // The LFO steps at the same samples however the buffers fall
+      std::vector<float> actual = filter(pieces);
+      std::vector<float> expected(mInput);
+      whole.Process(&expected[0], kLength);
+
+      assert(actual == expected);
+
+      std::cout << "ok\n";
+   }
+
+   void testCloseToOriginal()
+   {
+      std::cout << "\tthe held biquad should stay close to the original filter..." << std::flush;
+
+      double rates[] = { 8000, 44100, 96000 };
+      float freqs[] = { 0.1f, 1.5f, 4.0f };
+      float phases[] = { 0, (float)M_PI };
+      float depths[] = { 0, 0.7f, 1.0f };
+      float resonances[] = { 0.1f, 2.5f, 10.0f };
+
+      setUp();
+
+      for (int r = 0; r < 3; r++) {
+         for (int f = 0; f < 3; f++) {
+            for (int p = 0; p < 2; p++) {
+               for (int d = 0; d < 3; d++) {
+                  for (int q = 0; q < 3; q++) {
+                     OriginalWahwah original(rates[r], freqs[f], phases[p],
+                                             depths[d], 0.3f, resonances[q]);
+                     WahwahFilter wahwah;
+                     wahwah.Init(rates[r], freqs[f], phases[p],
+                                 depths[d], 0.3f, resonances[q]);
+
+                     std::vector<float> expected = filter(original);
+                     std::vector<float> actual = filter(wahwah);
+
+                     // The coefficients are divided through by a0 when the
+                     // LFO moves, where the original divided every sample,
+                     // so only rounding may differ.  When the sweep reaches
+                     // down to a few hundred Hz the poles are close to 1,
+                     // which magnifies that most at low resonance and high
+                     // rates.
+                     double peak = 0, error = 0;
+                     for (int i = 0; i < kLength; i++) {
+                        peak = std::max(peak, (double)fabs(expected[i]));
+                        error = std::max(error, (double)fabs(actual[i] - expected[i]));
+                     }
+
+                     if (error > 2e-2 * peak) {
+                        std::cout << "rate " << rates[r]
+                                  << ", frequency " << freqs[f]
+                                  << ", phase " << phases[p]
+                                  << ", depth " << depths[d]
+                                  << ", resonance " << resonances[q]
+                                  << ": error " << error
+                                  << " against a peak of " << peak << std::endl;
+                        assert(false);
+                     }
+                  }
+               }
+            }
+         }
+      }
+
+      std::cout << "ok\n";
+   }
+};
+
+int main()
+{
+   WahwahTest tester;
+
+   tester.testBuffersMatchOneBuffer();
+   tester.testCloseToOriginal();
+
+   return 0;
+}
+
+// Indentation settings for Vim and Emacs and unique identifier for Arch, a
+// version control system. Please do not modify past this point.
+//
+// Local Variables:
+// c-basic-offset: 3
+// indent-tabs-mode: nil
+// End:
+//
+// vim: et sts=3 sw=3